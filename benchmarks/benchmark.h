@@ -0,0 +1,280 @@
+/**
+ * benchmark.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_BENCHMARKS_BENCHMARK_H_
+#define REDIS_GL_BENCHMARKS_BENCHMARK_H_
+
+// std
+#include <algorithm>  // std::sort
+#include <chrono>     // std::chrono
+#include <csignal>    // ::kill, SIGTERM
+#include <cstdlib>    // std::exit
+#include <ctime>      // std::time
+#include <fstream>    // std::ofstream
+#include <iostream>   // std::cout, std::cerr
+#include <map>        // std::map
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <thread>     // std::this_thread
+#include <utility>    // std::move
+#include <vector>     // std::vector
+
+// posix
+#include <arpa/inet.h>   // ::inet_pton
+#include <netinet/in.h>  // sockaddr_in
+#include <sys/socket.h>  // ::socket, ::connect
+#include <sys/wait.h>    // ::waitpid
+#include <unistd.h>      // ::fork, ::execvp, ::close
+
+// external
+#include <ctrl_utils/json.h>
+
+namespace redis_gl {
+
+namespace benchmark {
+
+/**
+ * Prevents the compiler from optimizing away a computed value.
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Command line flags of the form `--name=value`.
+ */
+class Flags {
+ public:
+  Flags(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg.compare(0, 2, "--") != 0) continue;
+      const size_t idx_eq = arg.find('=');
+      if (idx_eq == std::string::npos) {
+        flags_[arg.substr(2)] = "true";
+      } else {
+        flags_[arg.substr(2, idx_eq - 2)] = arg.substr(idx_eq + 1);
+      }
+    }
+  }
+
+  std::string Get(const std::string& name, const std::string& val) const {
+    auto it = flags_.find(name);
+    return it == flags_.end() ? val : it->second;
+  }
+
+  double Get(const std::string& name, double val) const {
+    auto it = flags_.find(name);
+    return it == flags_.end() ? val : std::stod(it->second);
+  }
+
+ private:
+  std::map<std::string, std::string> flags_;
+};
+
+/**
+ * Summary statistics of one benchmark in nanoseconds per iteration.
+ */
+struct Result {
+  std::string name;
+  nlohmann::json params = nlohmann::json::object();
+  size_t iterations = 0;
+  size_t items_per_iteration = 1;
+  double mean = 0.;
+  double min = 0.;
+  double p50 = 0.;
+  double p99 = 0.;
+  double max = 0.;
+
+  // Extra counters, e.g. dropped frames.
+  nlohmann::json counters = nlohmann::json::object();
+};
+
+inline void to_json(nlohmann::json& json, const Result& result) {
+  json["name"] = result.name;
+  json["params"] = result.params;
+  json["iterations"] = result.iterations;
+  json["time_unit"] = "ns";
+  json["mean"] = result.mean;
+  json["min"] = result.min;
+  json["p50"] = result.p50;
+  json["p99"] = result.p99;
+  json["max"] = result.max;
+  json["items_per_second"] =
+      result.mean > 0. ? 1e9 * result.items_per_iteration / result.mean : 0.;
+  json["counters"] = result.counters;
+}
+
+/**
+ * Computes summary statistics from samples in nanoseconds.
+ */
+inline Result Summarize(const std::string& name, std::vector<double> samples) {
+  Result result;
+  result.name = name;
+  result.iterations = samples.size();
+  if (samples.empty()) return result;
+
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.;
+  for (const double sample : samples) sum += sample;
+  const auto percentile = [&samples](double p) {
+    return samples[static_cast<size_t>(p * (samples.size() - 1))];
+  };
+  result.mean = sum / samples.size();
+  result.min = samples.front();
+  result.p50 = percentile(0.5);
+  result.p99 = percentile(0.99);
+  result.max = samples.back();
+  return result;
+}
+
+/**
+ * Runs a function repeatedly for at least `min_time` seconds and
+ * `min_iterations` iterations after one warm-up call.
+ */
+template <typename Function>
+inline Result Run(const std::string& name, Function&& fn,
+                  double min_time = 0.5, size_t min_iterations = 10) {
+  using Clock = std::chrono::steady_clock;
+  fn();
+
+  std::vector<double> samples;
+  const Clock::time_point t_end =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(min_time));
+  while (samples.size() < min_iterations || Clock::now() < t_end) {
+    const Clock::time_point t_start = Clock::now();
+    fn();
+    samples.push_back(
+        std::chrono::duration<double, std::nano>(Clock::now() - t_start)
+            .count());
+  }
+  return Summarize(name, std::move(samples));
+}
+
+/**
+ * Collects results and writes them as json to `--out=<path>` or stdout.
+ *
+ * Benchmarks whose name does not contain `--filter=<substring>` are skipped.
+ */
+class Reporter {
+ public:
+  Reporter(const std::string& suite, const Flags& flags)
+      : suite_(suite),
+        filter_(flags.Get("filter", std::string())),
+        path_out_(flags.Get("out", std::string())) {}
+
+  bool Enabled(const std::string& name) const {
+    return filter_.empty() || name.find(filter_) != std::string::npos;
+  }
+
+  void Add(const Result& result) {
+    std::cerr << result.name << ": " << result.p50 << " ns (p50), "
+              << result.p99 << " ns (p99)" << std::endl;
+    results_.push_back(result);
+  }
+
+  void Write() const {
+    nlohmann::json json;
+    json["context"]["suite"] = suite_;
+    json["context"]["date"] = static_cast<int64_t>(std::time(nullptr));
+#ifdef NDEBUG
+    json["context"]["build_type"] = "release";
+#else
+    json["context"]["build_type"] = "debug";
+#endif
+    json["benchmarks"] = results_;
+
+    if (path_out_.empty()) {
+      std::cout << json.dump(2) << std::endl;
+      return;
+    }
+    std::ofstream file(path_out_);
+    file << json.dump(2) << std::endl;
+  }
+
+ private:
+  std::string suite_;
+  std::string filter_;
+  std::string path_out_;
+  std::vector<Result> results_;
+};
+
+/**
+ * Child process that is terminated when this object is destroyed.
+ */
+class Subprocess {
+ public:
+  explicit Subprocess(std::vector<std::string> args) {
+    pid_ = ::fork();
+    if (pid_ < 0) throw std::runtime_error("Subprocess(): fork failed.");
+    if (pid_ == 0) {
+      std::vector<char*> argv;
+      for (std::string& arg : args) argv.push_back(&arg[0]);
+      argv.push_back(nullptr);
+      ::execvp(argv[0], argv.data());
+      std::cerr << "Subprocess(): could not execute " << args[0] << std::endl;
+      std::exit(1);
+    }
+  }
+
+  ~Subprocess() {
+    ::kill(pid_, SIGTERM);
+    ::waitpid(pid_, nullptr, 0);
+  }
+
+  Subprocess(const Subprocess&) = delete;
+  Subprocess& operator=(const Subprocess&) = delete;
+
+ private:
+  pid_t pid_ = -1;
+};
+
+/**
+ * Waits until a TCP port on localhost accepts connections.
+ */
+inline void WaitForPort(int port, double timeout = 10.) {
+  using Clock = std::chrono::steady_clock;
+  const Clock::time_point t_end =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(timeout));
+  while (Clock::now() < t_end) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    const bool connected =
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    ::close(fd);
+    if (connected) return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  throw std::runtime_error("WaitForPort(): timed out waiting for port " +
+                           std::to_string(port) + ".");
+}
+
+/**
+ * Throwaway redis-server without persistence.
+ */
+class RedisServer : public Subprocess {
+ public:
+  explicit RedisServer(int port)
+      : Subprocess({"redis-server", "--port", std::to_string(port), "--save",
+                    "", "--appendonly", "no"}) {
+    WaitForPort(port);
+  }
+};
+
+}  // namespace benchmark
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_BENCHMARKS_BENCHMARK_H_
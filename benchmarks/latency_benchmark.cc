@@ -0,0 +1,185 @@
+/**
+ * latency_benchmark.cc
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ *
+ * End-to-end latency from a controller SET to the WebSocket frame that
+ * carries the new value. Spawns a redis-server and server.py, connects to the
+ * WebSocket port like a browser, and times each update.
+ *
+ * Usage: redis_gl_benchmark_latency [--out=<path>] [--iterations=200]
+ *                                   [--refresh_rate=0.05] [--python=python3]
+ *                                   [--server=<path to server.py>]
+ *                                   [--redis_port=6390] [--http_port=8090]
+ *                                   [--ws_port=8091]
+ */
+
+#include <redis_gl/redis_gl.h>
+
+// std
+#include <chrono>   // std::chrono
+#include <cstdint>  // uint8_t, uint64_t
+#include <string>   // std::string
+#include <thread>   // std::this_thread
+#include <vector>   // std::vector
+
+// posix
+#include <sys/time.h>  // timeval
+
+#include "benchmark.h"
+
+namespace {
+
+/**
+ * Minimal blocking WebSocket client that only reads server frames.
+ */
+class WebSocketClient {
+ public:
+  WebSocketClient(int port, double timeout) {
+    fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      throw std::runtime_error("WebSocketClient(): could not connect.");
+    }
+
+    timeval tv;
+    tv.tv_sec = static_cast<time_t>(timeout);
+    tv.tv_usec = static_cast<suseconds_t>(1e6 * (timeout - tv.tv_sec));
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    const std::string request =
+        "GET / HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    ::send(fd_, request.data(), request.size(), 0);
+
+    // Skip the handshake response
+    std::string response;
+    char c;
+    while (response.size() < 4 ||
+           response.compare(response.size() - 4, 4, "\r\n\r\n") != 0) {
+      if (::recv(fd_, &c, 1, 0) != 1) {
+        throw std::runtime_error("WebSocketClient(): handshake failed.");
+      }
+      response.push_back(c);
+    }
+  }
+
+  ~WebSocketClient() { ::close(fd_); }
+
+  WebSocketClient(const WebSocketClient&) = delete;
+  WebSocketClient& operator=(const WebSocketClient&) = delete;
+
+  /**
+   * Reads the next frame.
+   *
+   * @return False on timeout or disconnection.
+   */
+  bool Read(std::string* payload) {
+    uint8_t header[2];
+    if (!ReadExactly(header, sizeof(header))) return false;
+
+    uint64_t len = header[1] & 0x7f;
+    if (len >= 126) {
+      const size_t num_bytes = len == 126 ? 2 : 8;
+      uint8_t ext[8];
+      if (!ReadExactly(ext, num_bytes)) return false;
+      len = 0;
+      for (size_t i = 0; i < num_bytes; i++) len = (len << 8) | ext[i];
+    }
+
+    payload->resize(len);
+    return len == 0 || ReadExactly(&(*payload)[0], len);
+  }
+
+ private:
+  bool ReadExactly(void* buffer, size_t len) {
+    char* ptr = static_cast<char*>(buffer);
+    while (len > 0) {
+      const ssize_t num_read = ::recv(fd_, ptr, len, 0);
+      if (num_read <= 0) return false;
+      ptr += num_read;
+      len -= static_cast<size_t>(num_read);
+    }
+    return true;
+  }
+
+  int fd_ = -1;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  using Clock = std::chrono::steady_clock;
+
+  const redis_gl::benchmark::Flags flags(argc, argv);
+  redis_gl::benchmark::Reporter reporter("latency", flags);
+
+  const int redis_port = static_cast<int>(flags.Get("redis_port", 6390.));
+  const int http_port = static_cast<int>(flags.Get("http_port", 8090.));
+  const int ws_port = static_cast<int>(flags.Get("ws_port", 8091.));
+  const size_t num_iterations =
+      static_cast<size_t>(flags.Get("iterations", 200.));
+  const double refresh_rate = flags.Get("refresh_rate", 0.05);
+  const double timeout = flags.Get("timeout", 2.);
+
+  redis_gl::benchmark::RedisServer redis_server(redis_port);
+  redis_gl::benchmark::Subprocess server(
+      {flags.Get("python", std::string("python3")),
+       flags.Get("server", std::string(REDIS_GL_SERVER_PY)), "-rp",
+       std::to_string(redis_port), "-hp", std::to_string(http_port), "-wp",
+       std::to_string(ws_port), "-r", std::to_string(refresh_rate)});
+  redis_gl::benchmark::WaitForPort(ws_port);
+
+  ctrl_utils::RedisClient redis;
+  redis.connect("127.0.0.1", redis_port);
+  WebSocketClient client(ws_port, timeout);
+
+  const std::string key = "benchmark::latency";
+  std::vector<double> latencies;
+  size_t num_dropped = 0;
+  std::string payload;
+  for (size_t i = 0; i < num_iterations; i++) {
+    const std::string val = "redis-gl-benchmark-" + std::to_string(i);
+    const Clock::time_point t_set = Clock::now();
+    redis.send({"SET", key, val}, [](cpp_redis::reply&) {});
+    redis.commit();
+
+    // Wait for the frame containing the new value
+    bool received = false;
+    while (client.Read(&payload)) {
+      if (payload.find(val) == std::string::npos) continue;
+      received = true;
+      break;
+    }
+    if (!received) {
+      num_dropped++;
+      continue;
+    }
+    latencies.push_back(
+        std::chrono::duration<double, std::nano>(Clock::now() - t_set)
+            .count());
+
+    // Desynchronize from the server's poll loop
+    std::this_thread::sleep_for(std::chrono::duration<double>(
+        refresh_rate * (0.25 + 0.5 * (i % 7) / 7.)));
+  }
+
+  redis_gl::benchmark::Result result = redis_gl::benchmark::Summarize(
+      "SET->WebSocket", std::move(latencies));
+  result.params["refresh_rate"] = refresh_rate;
+  result.counters["dropped"] = num_dropped;
+  reporter.Add(result);
+
+  reporter.Write();
+  return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * registration_benchmark.cc
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ *
+ * Registration throughput for scenes of 10 to 10,000 objects against a
+ * locally spawned redis-server.
+ *
+ * Usage: redis_gl_benchmark_registration [--out=<path>] [--filter=<name>]
+ *                                        [--redis_port=6390]
+ */
+
+#include <redis_gl/redis_gl.h>
+#include <redis_gl/robot.h>
+#include <redis_gl/scene.h>
+
+// std
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "benchmark.h"
+
+namespace {
+
+using ::redis_gl::benchmark::Reporter;
+using ::redis_gl::benchmark::Run;
+namespace simulator = ::redis_gl::simulator;
+
+std::vector<simulator::ObjectModel> CreateObjects(size_t num_objects) {
+  std::vector<simulator::ObjectModel> objects(num_objects);
+  for (size_t i = 0; i < num_objects; i++) {
+    simulator::ObjectModel& object = objects[i];
+    object.name = "object" + std::to_string(i);
+    spatial_dyn::Graphics graphics;
+    graphics.name = object.name;
+    graphics.geometry.type = spatial_dyn::Graphics::Geometry::Type::kBox;
+    graphics.geometry.scale = Eigen::Vector3d(0.1, 0.1, 0.1);
+    object.graphics = {graphics};
+    object.key_pos = "benchmark::" + object.name + "::pos";
+    object.key_ori = "benchmark::" + object.name + "::ori";
+  }
+  return objects;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const redis_gl::benchmark::Flags flags(argc, argv);
+  Reporter reporter("registration", flags);
+
+  const int redis_port = static_cast<int>(flags.Get("redis_port", 6390.));
+  redis_gl::benchmark::RedisServer redis_server(redis_port);
+
+  ctrl_utils::RedisClient redis;
+  redis.connect("127.0.0.1", redis_port);
+  const simulator::ModelKeys model_keys("benchmark");
+
+  for (const size_t num_objects : {10, 100, 1000, 10000}) {
+    const std::vector<simulator::ObjectModel> objects =
+        CreateObjects(num_objects);
+    const std::string suffix = "/" + std::to_string(num_objects);
+
+    // One command per object
+    if (reporter.Enabled("RegisterObject" + suffix)) {
+      redis_gl::benchmark::Result result =
+          Run("RegisterObject" + suffix, [&]() {
+            for (const simulator::ObjectModel& object : objects) {
+              simulator::RegisterObject(redis, model_keys, object);
+            }
+            redis.sync_commit();
+          });
+      result.params["num_objects"] = num_objects;
+      result.items_per_iteration = num_objects;
+      reporter.Add(result);
+    }
+
+    // Parallel serialization and a single batch
+    if (reporter.Enabled("RegisterScene" + suffix)) {
+      redis_gl::benchmark::Result result =
+          Run("RegisterScene" + suffix, [&]() {
+            simulator::RegisterScene(redis, model_keys, {}, objects);
+          });
+      result.params["num_objects"] = num_objects;
+      result.items_per_iteration = num_objects;
+      reporter.Add(result);
+    }
+
+    simulator::ClearModelKeys(redis, model_keys, false);
+    redis.sync_commit();
+  }
+
+  reporter.Write();
+  return 0;
+}
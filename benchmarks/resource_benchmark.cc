@@ -0,0 +1,236 @@
+/**
+ * resource_benchmark.cc
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ *
+ * Time for the viewer to load the meshes of a robot from a directory
+ * registered with RegisterResourcePath. Spawns a redis-server and server.py,
+ * and fetches every file over parallel connections like a browser, first in
+ * full and then revalidating with the ETags of the first responses. Pass the
+ * server.py of another checkout with --server to compare handlers.
+ *
+ * Usage: redis_gl_benchmark_resource [--out=<path>] [--filter=<name>]
+ *                                    [--num_files=40] [--file_size=262144]
+ *                                    [--connections=6] [--python=python3]
+ *                                    [--server=<path to server.py>]
+ *                                    [--redis_port=6390] [--http_port=8090]
+ *                                    [--ws_port=8091]
+ */
+
+#include <redis_gl/redis_gl.h>
+
+// std
+#include <atomic>     // std::atomic
+#include <cctype>     // std::tolower
+#include <cstdio>     // std::remove
+#include <cstdlib>    // std::atoi, ::mkdtemp
+#include <fstream>    // std::ofstream
+#include <iostream>   // std::cerr
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <thread>     // std::thread
+#include <vector>     // std::vector
+
+// posix
+#include <arpa/inet.h>   // ::inet_pton, htons
+#include <netinet/in.h>  // sockaddr_in
+#include <sys/socket.h>  // ::connect, ::recv, ::send, ::socket
+#include <unistd.h>      // ::close, ::rmdir
+
+#include "benchmark.h"
+
+namespace {
+
+using ::redis_gl::benchmark::Reporter;
+using ::redis_gl::benchmark::Run;
+
+struct Response {
+  int status = 0;
+  size_t size = 0;
+  std::string etag;
+};
+
+/**
+ * Sends one GET request and reads the response until the server closes the
+ * connection.
+ */
+Response Get(int port, const std::string& path, const std::string& etag) {
+  Response response;
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return response;
+  }
+
+  std::string request = "GET " + path +
+                        " HTTP/1.1\r\n"
+                        "Host: 127.0.0.1\r\n"
+                        "Connection: close\r\n";
+  if (!etag.empty()) request += "If-None-Match: " + etag + "\r\n";
+  request += "\r\n";
+  ::send(fd, request.data(), request.size(), 0);
+
+  // Keep the headers and count the body
+  std::string headers;
+  size_t idx_body = std::string::npos;
+  char buffer[65536];
+  ssize_t num_read;
+  while ((num_read = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    if (idx_body != std::string::npos) {
+      response.size += static_cast<size_t>(num_read);
+      continue;
+    }
+    headers.append(buffer, static_cast<size_t>(num_read));
+    idx_body = headers.find("\r\n\r\n");
+    if (idx_body == std::string::npos) continue;
+    response.size = headers.size() - idx_body - 4;
+    headers.resize(idx_body + 2);
+  }
+  ::close(fd);
+
+  // Parse "HTTP/1.x <status>" and the ETag header
+  const size_t idx_status = headers.find(' ');
+  if (idx_status == std::string::npos) return response;
+  response.status = std::atoi(headers.c_str() + idx_status + 1);
+
+  std::string headers_lower = headers;
+  for (char& c : headers_lower) c = static_cast<char>(std::tolower(c));
+  const size_t idx_etag = headers_lower.find("\r\netag:");
+  if (idx_etag != std::string::npos) {
+    const size_t idx_start = headers.find_first_not_of(' ', idx_etag + 7);
+    response.etag =
+        headers.substr(idx_start, headers.find("\r\n", idx_start) - idx_start);
+  }
+  return response;
+}
+
+/**
+ * Fetches every path over parallel connections, each taking the next
+ * unfetched path.
+ */
+std::vector<Response> GetAll(int port, const std::vector<std::string>& paths,
+                             const std::vector<std::string>& etags,
+                             size_t num_connections) {
+  std::vector<Response> responses(paths.size());
+  std::atomic<size_t> idx_next = {0};
+  std::vector<std::thread> connections;
+  for (size_t i = 0; i < num_connections; i++) {
+    connections.emplace_back([&]() {
+      for (size_t idx = idx_next++; idx < paths.size(); idx = idx_next++) {
+        responses[idx] = Get(port, paths[idx], etags[idx]);
+      }
+    });
+  }
+  for (std::thread& connection : connections) connection.join();
+  return responses;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const redis_gl::benchmark::Flags flags(argc, argv);
+  Reporter reporter("resource", flags);
+
+  const int redis_port = static_cast<int>(flags.Get("redis_port", 6390.));
+  const int http_port = static_cast<int>(flags.Get("http_port", 8090.));
+  const int ws_port = static_cast<int>(flags.Get("ws_port", 8091.));
+  const size_t num_files = static_cast<size_t>(flags.Get("num_files", 40.));
+  const size_t file_size =
+      static_cast<size_t>(flags.Get("file_size", 262144.));
+  const size_t num_connections =
+      static_cast<size_t>(flags.Get("connections", 6.));
+
+  // Meshes of a robot
+  char dir_template[] = "/tmp/redis_gl_resources_XXXXXX";
+  if (::mkdtemp(dir_template) == nullptr) {
+    throw std::runtime_error("mkdtemp(): could not create " +
+                             std::string(dir_template) + ".");
+  }
+  const std::string dir = dir_template;
+  std::vector<std::string> filenames;
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < num_files; i++) {
+    filenames.push_back(dir + "/link" + std::to_string(i) + ".obj");
+    paths.push_back("/resources/simulator/link" + std::to_string(i) + ".obj");
+    std::ofstream file(filenames.back(), std::ios::binary);
+    file << std::string(file_size, 'v');
+  }
+
+  {
+    redis_gl::benchmark::RedisServer redis_server(redis_port);
+    redis_gl::benchmark::Subprocess server(
+        {flags.Get("python", std::string("python3")),
+         flags.Get("server", std::string(REDIS_GL_SERVER_PY)), "-rp",
+         std::to_string(redis_port), "-hp", std::to_string(http_port), "-wp",
+         std::to_string(ws_port)});
+    redis_gl::benchmark::WaitForPort(http_port);
+
+    ctrl_utils::RedisClient redis;
+    redis.connect("127.0.0.1", redis_port);
+    redis_gl::simulator::RegisterResourcePath(redis, dir);
+    redis.sync_commit();
+
+    const std::vector<std::string> no_etags(num_files);
+    const std::vector<Response> responses =
+        GetAll(http_port, paths, no_etags, num_connections);
+    std::vector<std::string> etags;
+    size_t num_ok = 0;
+    for (const Response& response : responses) {
+      etags.push_back(response.etag);
+      num_ok += response.status == 200 && response.size == file_size;
+    }
+    if (num_ok != num_files) {
+      std::cerr << "Only " << num_ok << " of " << num_files
+                << " resources were served." << std::endl;
+    }
+
+    // Cold load of every file
+    if (reporter.Enabled("Load")) {
+      redis_gl::benchmark::Result result = Run("Load", [&]() {
+        redis_gl::benchmark::DoNotOptimize(
+            GetAll(http_port, paths, no_etags, num_connections));
+      });
+      result.params["num_files"] = num_files;
+      result.params["file_size"] = file_size;
+      result.params["connections"] = num_connections;
+      result.items_per_iteration = num_files;
+      reporter.Add(result);
+    }
+
+    // Reload with the browser cache
+    if (reporter.Enabled("Revalidate")) {
+      size_t num_not_modified = 0;
+      redis_gl::benchmark::Result result = Run("Revalidate", [&]() {
+        num_not_modified = 0;
+        for (const Response& response :
+             GetAll(http_port, paths, etags, num_connections)) {
+          num_not_modified += response.status == 304;
+        }
+      });
+      result.params["num_files"] = num_files;
+      result.params["file_size"] = file_size;
+      result.params["connections"] = num_connections;
+      result.items_per_iteration = num_files;
+      result.counters["not_modified"] = num_not_modified;
+      reporter.Add(result);
+    }
+
+    redis_gl::simulator::UnregisterResourcePath(redis, dir);
+    redis.sync_commit();
+  }
+
+  for (const std::string& filename : filenames) {
+    std::remove(filename.c_str());
+  }
+  ::rmdir(dir.c_str());
+
+  reporter.Write();
+  return 0;
+}
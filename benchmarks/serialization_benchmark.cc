@@ -0,0 +1,208 @@
+/**
+ * serialization_benchmark.cc
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ *
+ * Microbenchmarks for the json serializers and the stringstream operators
+ * used by ctrl_utils::RedisClient, and for the text and quantized state value
+ * formats.
+ *
+ * Usage: redis_gl_benchmark_serialization [--out=<path>] [--filter=<name>]
+ */
+
+#include <redis_gl/codec.h>
+#include <redis_gl/format.h>
+#include <redis_gl/redis_gl.h>
+#include <redis_gl/robot.h>
+
+// std
+#include <sstream>  // std::stringstream
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include "benchmark.h"
+
+namespace {
+
+using ::redis_gl::benchmark::DoNotOptimize;
+using ::redis_gl::benchmark::Reporter;
+using ::redis_gl::benchmark::Run;
+namespace simulator = ::redis_gl::simulator;
+
+spatial_dyn::Graphics CreateGraphics(const std::string& name) {
+  spatial_dyn::Graphics graphics;
+  graphics.name = name;
+  graphics.geometry.type = spatial_dyn::Graphics::Geometry::Type::kCapsule;
+  graphics.geometry.radius = 0.05;
+  graphics.geometry.length = 0.3;
+  return graphics;
+}
+
+/**
+ * Creates a serial chain similar to a 7-dof manipulator.
+ */
+simulator::RobotModel CreateRobot(size_t dof) {
+  auto ab = std::make_shared<spatial_dyn::ArticulatedBody>("robot");
+  int id_parent = -1;
+  for (size_t i = 0; i < dof; i++) {
+    const std::string name = "link" + std::to_string(i);
+    spatial_dyn::RigidBody rb(name);
+    rb.set_joint(spatial_dyn::Joint(spatial_dyn::Joint::Type::kRz));
+    rb.set_T_to_parent(Eigen::Quaterniond::Identity(),
+                       Eigen::Vector3d(0., 0., 0.3));
+    rb.graphics.push_back(CreateGraphics(name));
+    id_parent = ab->AddRigidBody(std::move(rb), id_parent);
+  }
+
+  simulator::RobotModel robot;
+  robot.articulated_body = ab;
+  robot.key_q = "benchmark::robot::q";
+  robot.key_pos = "benchmark::robot::pos";
+  robot.key_ori = "benchmark::robot::ori";
+  return robot;
+}
+
+simulator::ObjectModel CreateObject() {
+  simulator::ObjectModel object;
+  object.name = "box";
+  object.graphics = {CreateGraphics("box")};
+  object.key_pos = "benchmark::box::pos";
+  object.key_ori = "benchmark::box::ori";
+  object.key_scale = "benchmark::box::scale";
+  return object;
+}
+
+simulator::CameraModel CreateCamera() {
+  simulator::CameraModel camera;
+  camera.name = "camera";
+  camera.key_pos = "benchmark::camera::pos";
+  camera.key_ori = "benchmark::camera::ori";
+  camera.key_intrinsic = "benchmark::camera::intrinsic";
+  camera.key_depth_image = "benchmark::camera::depth";
+  camera.key_color_image = "benchmark::camera::color";
+  return camera;
+}
+
+simulator::Interaction CreateInteraction() {
+  simulator::Interaction interaction;
+  interaction.key_object = "benchmark::robot";
+  interaction.idx_link = 3;
+  interaction.pos_click_in_link = Eigen::Vector3d(0.1, 0.2, 0.3);
+  interaction.pos_mouse_in_world = Eigen::Vector3d(0.4, 0.5, 0.6);
+  interaction.modifier_keys = {simulator::Interaction::Key::kCtrl};
+  interaction.key_down = "a";
+  return interaction;
+}
+
+/**
+ * Benchmarks to_json, from_json, operator<< and operator>> for one type.
+ */
+template <typename T>
+void RunSerializers(Reporter& reporter, const std::string& type,
+                    const T& value) {
+  const nlohmann::json json = value;
+  const std::string str = json.dump();
+
+  const std::string name_to_json = type + "/to_json";
+  if (reporter.Enabled(name_to_json)) {
+    redis_gl::benchmark::Result result = Run(name_to_json, [&value]() {
+      nlohmann::json json_out = value;
+      DoNotOptimize(json_out);
+    });
+    result.params["num_bytes"] = str.size();
+    reporter.Add(result);
+  }
+
+  const std::string name_from_json = type + "/from_json";
+  if (reporter.Enabled(name_from_json)) {
+    redis_gl::benchmark::Result result = Run(name_from_json, [&json]() {
+      T value_out = json.get<T>();
+      DoNotOptimize(value_out);
+    });
+    result.params["num_bytes"] = str.size();
+    reporter.Add(result);
+  }
+
+  const std::string name_ostream = type + "/operator<<";
+  if (reporter.Enabled(name_ostream)) {
+    redis_gl::benchmark::Result result = Run(name_ostream, [&value]() {
+      std::stringstream ss;
+      ss << value;
+      DoNotOptimize(ss.str());
+    });
+    result.params["num_bytes"] = str.size();
+    reporter.Add(result);
+  }
+
+  const std::string name_istream = type + "/operator>>";
+  if (reporter.Enabled(name_istream)) {
+    redis_gl::benchmark::Result result = Run(name_istream, [&str]() {
+      std::stringstream ss(str);
+      T value_out;
+      ss >> value_out;
+      DoNotOptimize(value_out);
+    });
+    result.params["num_bytes"] = str.size();
+    reporter.Add(result);
+  }
+}
+
+/**
+ * Benchmarks the text and quantized formats of the poses of a fleet.
+ */
+void RunStateFormats(Reporter& reporter, size_t num_poses) {
+  std::vector<Eigen::Isometry3d> poses(num_poses);
+  for (Eigen::Isometry3d& pose : poses) {
+    pose.linear() = Eigen::Quaterniond::UnitRandom().toRotationMatrix();
+    pose.translation() = Eigen::Vector3d::Random();
+  }
+  const std::string type = "Isometry3d[" + std::to_string(num_poses) + "]";
+
+  // Text format of one key_pos and one key_ori per pose
+  std::string buffer;
+  const std::string name_text = type + "/text";
+  if (reporter.Enabled(name_text)) {
+    redis_gl::benchmark::Result result = Run(name_text, [&]() {
+      buffer.clear();
+      for (const Eigen::Isometry3d& pose : poses) {
+        simulator::internal::AppendMatrix(pose.translation(), &buffer);
+        simulator::internal::AppendMatrix(
+            Eigen::Quaterniond(pose.linear()).coeffs(), &buffer);
+      }
+      DoNotOptimize(buffer);
+    });
+    result.params["num_bytes"] = buffer.size();
+    reporter.Add(result);
+  }
+
+  const std::string name_codec = type + "/EncodeIsometries";
+  if (reporter.Enabled(name_codec)) {
+    const simulator::CodecPrecision precision;
+    redis_gl::benchmark::Result result = Run(name_codec, [&]() {
+      simulator::EncodeIsometries(poses, precision, &buffer);
+      DoNotOptimize(buffer);
+    });
+    result.params["num_bytes"] = buffer.size();
+    reporter.Add(result);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const redis_gl::benchmark::Flags flags(argc, argv);
+  Reporter reporter("serialization", flags);
+
+  RunSerializers(reporter, "RobotModel", CreateRobot(7));
+  RunSerializers(reporter, "ObjectModel", CreateObject());
+  RunSerializers(reporter, "CameraModel", CreateCamera());
+  RunSerializers(reporter, "Interaction", CreateInteraction());
+  RunStateFormats(reporter, 1);
+  RunStateFormats(reporter, 100);
+
+  reporter.Write();
+  return 0;
+}
@@ -0,0 +1,331 @@
+/**
+ * redisgl_bindings.cc
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ *
+ * Python bindings of the C++ state publish path, imported as
+ * redisgl._redisgl. NumPy arrays are read in place through the buffer
+ * protocol, and formatting and Redis commits run without the GIL.
+ */
+
+#include <redis_gl/codec.h>
+#include <redis_gl/format.h>
+
+// std
+#include <cstdint>    // uint8_t
+#include <mutex>      // std::lock_guard, std::mutex
+#include <optional>   // std::optional
+#include <stdexcept>  // std::invalid_argument
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+// external
+#include <ctrl_utils/redis_client.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace {
+
+namespace py = pybind11;
+namespace simulator = ::redis_gl::simulator;
+
+// C-contiguous float64 arrays are used in place. Other arrays are converted
+// once by pybind11.
+using Array = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// Rows may be column blocks of a wider array, e.g. the positions of (N, 7)
+// poses.
+using RowsXd =
+    Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
+                                   Eigen::RowMajor>,
+               0, Eigen::OuterStride<>>;
+
+/**
+ * Maps a (N, D) array, or a (D,) array as N = 1, as N rows without copying.
+ *
+ * @param dim Required row size, or 0 for any.
+ */
+RowsXd MapRows(const Array& array, Eigen::Index dim, const char* name) {
+  if (array.ndim() != 1 && array.ndim() != 2) {
+    throw std::invalid_argument(std::string(name) + " must be 1d or 2d.");
+  }
+  const Eigen::Index rows = array.ndim() == 1 ? 1 : array.shape(0);
+  const Eigen::Index cols = array.shape(array.ndim() - 1);
+  if (dim > 0 && cols != dim) {
+    throw std::invalid_argument(std::string(name) + " must have " +
+                                std::to_string(dim) + " columns.");
+  }
+  return RowsXd(array.data(), rows, cols, Eigen::OuterStride<>(cols));
+}
+
+void CheckNumKeys(const std::vector<std::string>& keys, const RowsXd& rows,
+                  const char* name) {
+  if (keys.size() != static_cast<size_t>(rows.rows())) {
+    throw std::invalid_argument(std::string(name) +
+                                " must have one row per key.");
+  }
+}
+
+/**
+ * Stages state values and sets them in one MSET command.
+ *
+ * Values are formatted in C++ as the text parsed by the viewer, or, given a
+ * CodecPrecision, in the quantized format of codec.h.
+ *
+ * All arguments are validated before anything is staged, so a call that
+ * raises stages no values. The staged command is guarded by a mutex, so the
+ * publisher may be shared between Python threads.
+ */
+class StatePublisher {
+ public:
+  StatePublisher(const std::string& host, size_t port,
+                 const std::string& password,
+                 const std::optional<simulator::CodecPrecision>& precision)
+      : precision_(precision) {
+    if (precision_) {
+      simulator::internal::CheckPrecision(*precision_, true, true);
+    }
+    redis_.connect(host, port, password);
+  }
+
+  /**
+   * Stages row i of the (N, D) values for keys[i], e.g. the joint positions
+   * of a fleet of robots.
+   */
+  void SetVectors(const std::vector<std::string>& keys, const Array& values) {
+    const RowsXd rows = MapRows(values, 0, "values");
+    CheckNumKeys(keys, rows, "values");
+
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(mtx_);
+    StageVectors(keys, rows);
+  }
+
+  /**
+   * Stages row i of the (N, 4) xyzw quaternions for keys[i].
+   */
+  void SetQuaternions(const std::vector<std::string>& keys,
+                      const Array& quats) {
+    const RowsXd rows = MapRows(quats, 4, "quats");
+    CheckNumKeys(keys, rows, "quats");
+
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(mtx_);
+    StageQuaternions(keys, rows);
+  }
+
+  /**
+   * Stages the (N, 3) positions and (N, 4) xyzw quaternions of a fleet.
+   */
+  void SetPoses(const std::vector<std::string>& keys_pos,
+                const std::vector<std::string>& keys_ori, const Array& pos,
+                const Array& quats) {
+    const RowsXd rows_pos = MapRows(pos, 3, "pos");
+    CheckNumKeys(keys_pos, rows_pos, "pos");
+    const RowsXd rows_quats = MapRows(quats, 4, "quats");
+    CheckNumKeys(keys_ori, rows_quats, "quats");
+    StagePoses(keys_pos, keys_ori, rows_pos, rows_quats);
+  }
+
+  /**
+   * Stages the (N, 7) poses of a fleet, with rows [x, y, z, qx, qy, qz, qw].
+   */
+  void SetPoses(const std::vector<std::string>& keys_pos,
+                const std::vector<std::string>& keys_ori,
+                const Array& poses) {
+    const RowsXd rows = MapRows(poses, 7, "poses");
+    CheckNumKeys(keys_pos, rows, "poses");
+    CheckNumKeys(keys_ori, rows, "poses");
+    const Eigen::OuterStride<> stride(rows.outerStride());
+    StagePoses(keys_pos, keys_ori, RowsXd(rows.data(), rows.rows(), 3, stride),
+               RowsXd(rows.data() + 3, rows.rows(), 4, stride));
+  }
+
+  /**
+   * Sends the staged values in one MSET command.
+   *
+   * @param sync Wait for the reply.
+   * @return Number of keys sent.
+   */
+  size_t Commit(bool sync) {
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (num_staged_ == 0) return 0;
+
+    command_.resize(1 + 2 * num_staged_);
+    command_[0] = "MSET";
+    redis_.send(command_, [](cpp_redis::reply&) {});
+    if (sync) {
+      redis_.sync_commit();
+    } else {
+      redis_.commit();
+    }
+
+    const size_t num_sent = num_staged_;
+    num_staged_ = 0;
+    return num_sent;
+  }
+
+ private:
+  void StagePoses(const std::vector<std::string>& keys_pos,
+                  const std::vector<std::string>& keys_ori,
+                  const RowsXd& rows_pos, const RowsXd& rows_quats) {
+    py::gil_scoped_release release;
+    std::lock_guard<std::mutex> lock(mtx_);
+    const size_t num_staged = num_staged_;
+    try {
+      StageVectors(keys_pos, rows_pos);
+      StageQuaternions(keys_ori, rows_quats);
+    } catch (...) {
+      num_staged_ = num_staged;
+      throw;
+    }
+  }
+
+  void StageVectors(const std::vector<std::string>& keys, const RowsXd& rows) {
+    const size_t num_staged = num_staged_;
+    try {
+      for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i].empty()) continue;
+        std::string& val = Stage(keys[i]);
+        if (precision_) {
+          simulator::EncodeVectors(rows.row(i).transpose(), *precision_, &val);
+        } else {
+          simulator::internal::AppendMatrix(rows.row(i).transpose(), &val);
+        }
+      }
+    } catch (...) {
+      num_staged_ = num_staged;
+      throw;
+    }
+  }
+
+  void StageQuaternions(const std::vector<std::string>& keys,
+                        const RowsXd& rows) {
+    const size_t num_staged = num_staged_;
+    try {
+      for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i].empty()) continue;
+        std::string& val = Stage(keys[i]);
+        if (precision_) {
+          simulator::EncodeQuaternions(rows.row(i).transpose(), *precision_,
+                                       &val);
+        } else {
+          simulator::internal::AppendMatrix(rows.row(i).transpose(), &val);
+        }
+      }
+    } catch (...) {
+      num_staged_ = num_staged;
+      throw;
+    }
+  }
+
+  /**
+   * Returns the cleared value buffer of the next staged key. The command
+   * buffers are reused across commits.
+   */
+  std::string& Stage(const std::string& key) {
+    const size_t idx = 1 + 2 * num_staged_++;
+    if (command_.size() < idx + 2) command_.resize(idx + 2);
+    command_[idx] = key;
+    command_[idx + 1].clear();
+    return command_[idx + 1];
+  }
+
+  ctrl_utils::RedisClient redis_;
+  std::optional<simulator::CodecPrecision> precision_;
+  // Guards command_ and num_staged_, which are modified without the GIL
+  std::mutex mtx_;
+  std::vector<std::string> command_;
+  size_t num_staged_ = 0;
+};
+
+}  // namespace
+
+PYBIND11_MODULE(_redisgl, m) {
+  m.doc() = "Python bindings of the redis_gl C++ state publishers.";
+
+  py::class_<simulator::CodecPrecision>(m, "CodecPrecision")
+      .def(py::init([](double resolution, uint8_t vector_bits,
+                       uint8_t quaternion_bits) {
+             simulator::CodecPrecision precision;
+             precision.resolution = resolution;
+             precision.vector_bits = vector_bits;
+             precision.quaternion_bits = quaternion_bits;
+             return precision;
+           }),
+           py::arg("resolution") = 1e-5, py::arg("vector_bits") = 32,
+           py::arg("quaternion_bits") = 10)
+      .def_readwrite("resolution", &simulator::CodecPrecision::resolution)
+      .def_readwrite("vector_bits", &simulator::CodecPrecision::vector_bits)
+      .def_readwrite("quaternion_bits",
+                     &simulator::CodecPrecision::quaternion_bits);
+
+  py::class_<StatePublisher>(m, "StatePublisher")
+      .def(py::init<const std::string&, size_t, const std::string&,
+                    const std::optional<simulator::CodecPrecision>&>(),
+           py::arg("host") = "127.0.0.1", py::arg("port") = 6379,
+           py::arg("password") = "", py::arg("precision") = py::none())
+      .def("set_vectors", &StatePublisher::SetVectors, py::arg("keys"),
+           py::arg("values"))
+      .def("set_quaternions", &StatePublisher::SetQuaternions,
+           py::arg("keys"), py::arg("quats"))
+      .def("set_poses",
+           py::overload_cast<const std::vector<std::string>&,
+                             const std::vector<std::string>&, const Array&,
+                             const Array&>(&StatePublisher::SetPoses),
+           py::arg("keys_pos"), py::arg("keys_ori"), py::arg("pos"),
+           py::arg("quats"))
+      .def("set_poses",
+           py::overload_cast<const std::vector<std::string>&,
+                             const std::vector<std::string>&, const Array&>(
+               &StatePublisher::SetPoses),
+           py::arg("keys_pos"), py::arg("keys_ori"), py::arg("poses"))
+      .def("commit", &StatePublisher::Commit, py::arg("sync") = false);
+
+  // Encoders of a whole batch as one value, e.g. for redis-py.
+  m.def(
+      "encode_vectors",
+      [](const Array& values, const simulator::CodecPrecision& precision) {
+        const RowsXd rows = MapRows(values, 0, "values");
+        std::string buffer;
+        {
+          py::gil_scoped_release release;
+          simulator::EncodeVectors(rows.transpose(), precision, &buffer);
+        }
+        return py::bytes(buffer);
+      },
+      py::arg("values"), py::arg("precision") = simulator::CodecPrecision());
+  m.def(
+      "encode_quaternions",
+      [](const Array& quats, const simulator::CodecPrecision& precision) {
+        const RowsXd rows = MapRows(quats, 4, "quats");
+        std::string buffer;
+        {
+          py::gil_scoped_release release;
+          simulator::EncodeQuaternions(rows.transpose(), precision, &buffer);
+        }
+        return py::bytes(buffer);
+      },
+      py::arg("quats"), py::arg("precision") = simulator::CodecPrecision());
+  m.def(
+      "encode_poses",
+      [](const Array& pos, const Array& quats,
+         const simulator::CodecPrecision& precision) {
+        const RowsXd rows_pos = MapRows(pos, 3, "pos");
+        const RowsXd rows_quats = MapRows(quats, 4, "quats");
+        std::string buffer;
+        {
+          py::gil_scoped_release release;
+          simulator::EncodePoses(rows_pos.transpose(), rows_quats.transpose(),
+                                 precision, &buffer);
+        }
+        return py::bytes(buffer);
+      },
+      py::arg("pos"), py::arg("quats"),
+      py::arg("precision") = simulator::CodecPrecision());
+}
@@ -0,0 +1,353 @@
+/**
+ * coalescing_publisher.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_COALESCING_PUBLISHER_H_
+#define REDIS_GL_COALESCING_PUBLISHER_H_
+
+#include "redis_gl/frame_publisher.h"
+#include "redis_gl/triple_buffer.h"
+
+// std
+#include <algorithm>      // std::stable_sort
+#include <atomic>         // std::atomic
+#include <chrono>         // std::chrono
+#include <cstdint>        // uint64_t
+#include <memory>         // std::unique_ptr
+#include <stdexcept>      // std::invalid_argument
+#include <string>         // std::string
+#include <thread>         // std::thread
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Coalesces high-frequency state writes from a control loop and flushes only
+ * the latest value of each key to Redis at display rate.
+ *
+ * The control thread calls Set() every tick. Set() is wait-free and, once the
+ * value buffers have grown to size, does not allocate. A background thread
+ * wakes up at the display rate, formats the latest value of every key that
+ * changed since its last flush, and sends them all in one MSET. Updates that
+ * were overwritten before they could be flushed are counted as suppressed.
+ *
+ * Each key can have a lower rate than the display rate (e.g. camera poses
+ * slower than joint angles) and a priority. If max_bytes_per_flush is set,
+ * keys are flushed in order of priority until the budget is used up, and the
+ * rest are deferred. Deferred keys are flushed first in the next flushes,
+ * oldest first, so low priority keys are delayed but never starved.
+ *
+ * Example:
+ *
+ *     ctrl_utils::RedisClient redis_publisher;
+ *     redis_publisher.connect();
+ *     CoalescingPublisher publisher(redis_publisher,
+ *                                   {{robot.key_q, 0., 1},
+ *                                    {camera.key_pos, 10.}});
+ *     const auto handle_q = publisher.handle(robot.key_q);
+ *
+ *     while (true) {
+ *       // Wait-free
+ *       publisher.Set(handle_q, ab.q());
+ *     }
+ */
+class CoalescingPublisher {
+ public:
+  using Handle = size_t;
+
+  /**
+   * Options of one key.
+   */
+  struct Key {
+    Key(const std::string& key, double rate = 0., int priority = 0)
+        : key(key), rate(rate), priority(priority) {}
+
+    std::string key;
+
+    // Maximum flush rate in Hz. A rate of 0 flushes at the display rate.
+    double rate = 0.;
+
+    // Keys with higher priority are flushed first.
+    int priority = 0;
+  };
+
+  /**
+   * Starts the flush thread.
+   *
+   * @param redis Connected Redis client used exclusively by the flush thread.
+   * @param keys Keys that can be set. Handles are indices into this list.
+   * @param rate Display rate in Hz.
+   * @param max_bytes_per_flush Soft limit on the size of each flush, or 0 for
+   *                            no limit. At least one key is always flushed.
+   */
+  CoalescingPublisher(ctrl_utils::RedisClient& redis,
+                      const std::vector<Key>& keys, double rate = 60.,
+                      size_t max_bytes_per_flush = 0)
+      : redis_(redis),
+        period_(ToDuration(rate)),
+        max_bytes_per_flush_(max_bytes_per_flush) {
+    channels_.reserve(keys.size());
+    deferred_.reserve(keys.size());
+    for (const Key& key : keys) {
+      if (idx_channels_.count(key.key) > 0) {
+        throw std::invalid_argument("CoalescingPublisher(): duplicate key " +
+                                    key.key + ".");
+      }
+      idx_channels_[key.key] = channels_.size();
+      channels_.emplace_back(new Channel(key, period_));
+    }
+
+    // Flush order by descending priority
+    order_.resize(channels_.size());
+    for (size_t i = 0; i < order_.size(); i++) order_[i] = i;
+    std::stable_sort(order_.begin(), order_.end(), [this](size_t a, size_t b) {
+      return channels_[a]->priority > channels_[b]->priority;
+    });
+
+    thread_ = std::thread(&CoalescingPublisher::Run, this);
+  }
+
+  /**
+   * Flushes the remaining values and stops the flush thread.
+   */
+  ~CoalescingPublisher() {
+    running_ = false;
+    thread_.join();
+  }
+
+  CoalescingPublisher(const CoalescingPublisher&) = delete;
+  CoalescingPublisher& operator=(const CoalescingPublisher&) = delete;
+
+  /**
+   * Returns the handle of a key passed to the constructor.
+   */
+  Handle handle(const std::string& key) const {
+    auto it = idx_channels_.find(key);
+    if (it == idx_channels_.end()) {
+      throw std::out_of_range("CoalescingPublisher::handle(): unknown key " +
+                              key + ".");
+    }
+    return it->second;
+  }
+
+  /**
+   * Sets the latest value of a key.
+   *
+   * This function is wait-free. It may only be called from one thread.
+   */
+  template <typename Derived>
+  void Set(Handle handle, const Eigen::DenseBase<Derived>& value) {
+    Channel& channel = *channels_[handle];
+    Value& back = channel.buffer.back();
+    back.matrix = value.template cast<double>();
+    back.is_string = false;
+    Publish(channel);
+  }
+
+  /**
+   * Sets the latest value of a quaternion key in xyzw order.
+   */
+  void Set(Handle handle, const Eigen::Quaterniond& quat) {
+    Set(handle, quat.coeffs());
+  }
+
+  /**
+   * Sets the latest preformatted string value of a key.
+   */
+  void Set(Handle handle, const std::string& value) {
+    Channel& channel = *channels_[handle];
+    Value& back = channel.buffer.back();
+    back.str = value;
+    back.is_string = true;
+    Publish(channel);
+  }
+
+  /**
+   * Number of Set() calls whose values were overwritten before they could be
+   * flushed.
+   */
+  uint64_t num_suppressed() const {
+    uint64_t num_suppressed = 0;
+    for (size_t i = 0; i < channels_.size(); i++) {
+      num_suppressed += this->num_suppressed(i);
+    }
+    return num_suppressed;
+  }
+
+  /**
+   * Number of suppressed Set() calls of one key.
+   */
+  uint64_t num_suppressed(Handle handle) const {
+    const Channel& channel = *channels_[handle];
+    const uint64_t num_flushed =
+        channel.num_flushed.load(std::memory_order_acquire);
+    return channel.num_sets_flushed.load(std::memory_order_relaxed) -
+           num_flushed;
+  }
+
+  /**
+   * Number of values flushed to Redis.
+   */
+  uint64_t num_flushed() const {
+    uint64_t num_flushed = 0;
+    for (const std::unique_ptr<Channel>& channel : channels_) {
+      num_flushed += channel->num_flushed.load(std::memory_order_relaxed);
+    }
+    return num_flushed;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Value {
+    Eigen::MatrixXd matrix;
+    std::string str;
+    bool is_string = false;
+
+    // Number of Set() calls up to and including this value.
+    uint64_t num_sets = 0;
+  };
+
+  struct Channel {
+    Channel(const Key& key, Clock::duration period_display)
+        : key(key.key),
+          period(key.rate > 0. ? std::max(ToDuration(key.rate), period_display)
+                               : period_display),
+          priority(key.priority) {}
+
+    const std::string key;
+    const Clock::duration period;
+    const int priority;
+
+    TripleBuffer<Value> buffer;
+
+    // Control thread state
+    uint64_t num_sets = 0;
+
+    // Number of flushed values and of Set() calls up to the last of them.
+    std::atomic<uint64_t> num_sets_flushed = {0};
+    std::atomic<uint64_t> num_flushed = {0};
+
+    // Flush thread state
+    Clock::time_point t_next;
+    std::string val;
+    bool deferred = false;
+  };
+
+  static Clock::duration ToDuration(double rate) {
+    if (rate <= 0.) {
+      throw std::invalid_argument(
+          "CoalescingPublisher(): rate must be positive.");
+    }
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1. / rate));
+  }
+
+  static void Publish(Channel& channel) {
+    channel.buffer.back().num_sets = ++channel.num_sets;
+    channel.buffer.Publish();
+  }
+
+  void Run() {
+    Clock::time_point t_next = Clock::now();
+    while (running_) {
+      t_next += period_;
+      std::this_thread::sleep_until(t_next);
+      Flush(Clock::now(), false);
+    }
+
+    // Values set before the destructor was called
+    Flush(Clock::now(), true);
+  }
+
+  /**
+   * Sends the latest value of every due key.
+   *
+   * @param force Ignore per-key rates and the byte budget.
+   */
+  void Flush(Clock::time_point t_now, bool force) {
+    command_.clear();
+    command_.push_back("MSET");
+    size_t num_bytes = 0;
+    const auto is_over_budget = [this, force, &num_bytes]() {
+      return !force && max_bytes_per_flush_ > 0 && command_.size() > 1 &&
+             num_bytes >= max_bytes_per_flush_;
+    };
+
+    // Keys deferred by previous flushes, oldest first
+    size_t num_undeferred = 0;
+    for (; num_undeferred < deferred_.size() && !is_over_budget();
+         num_undeferred++) {
+      Channel& channel = *channels_[deferred_[num_undeferred]];
+      channel.buffer.Update();
+      channel.deferred = false;
+      Append(channel, t_now, &num_bytes);
+    }
+    deferred_.erase(deferred_.begin(), deferred_.begin() + num_undeferred);
+
+    // Due keys in order of priority
+    for (const size_t idx : order_) {
+      Channel& channel = *channels_[idx];
+      if (channel.deferred) continue;
+      if (!force && t_now < channel.t_next) continue;
+      if (!channel.buffer.Update()) continue;
+      if (is_over_budget()) {
+        channel.deferred = true;
+        deferred_.push_back(idx);
+        continue;
+      }
+      Append(channel, t_now, &num_bytes);
+    }
+    if (command_.size() == 1) return;
+
+    redis_.send(command_, [](cpp_redis::reply&) {});
+    redis_.commit();
+  }
+
+  /**
+   * Formats the front value of a channel into the MSET command.
+   */
+  void Append(Channel& channel, Clock::time_point t_now, size_t* num_bytes) {
+    const Value& value = channel.buffer.front();
+    channel.val.clear();
+    if (value.is_string) {
+      channel.val = value.str;
+    } else {
+      internal::AppendMatrix(value.matrix, &channel.val);
+    }
+    channel.t_next = t_now + channel.period;
+    channel.num_sets_flushed.store(value.num_sets, std::memory_order_relaxed);
+    channel.num_flushed.fetch_add(1, std::memory_order_release);
+
+    command_.push_back(channel.key);
+    command_.push_back(channel.val);
+    *num_bytes += channel.key.size() + channel.val.size();
+  }
+
+  ctrl_utils::RedisClient& redis_;
+  Clock::duration period_;
+  size_t max_bytes_per_flush_;
+
+  std::vector<std::unique_ptr<Channel>> channels_;
+  std::unordered_map<std::string, size_t> idx_channels_;
+  std::vector<size_t> order_;
+  std::vector<size_t> deferred_;
+  std::vector<std::string> command_;
+
+  std::atomic<bool> running_ = {true};
+  std::thread thread_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_COALESCING_PUBLISHER_H_
@@ -0,0 +1,414 @@
+/**
+ * codec.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_CODEC_H_
+#define REDIS_GL_CODEC_H_
+
+// std
+#include <cmath>        // std::sqrt
+#include <cstdint>      // int16_t, int32_t, uint8_t, uint32_t, uint64_t
+#include <cstring>      // std::memcpy, std::memset
+#include <limits>       // std::numeric_limits
+#include <stdexcept>    // std::invalid_argument
+#include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <vector>       // std::vector
+
+// external
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Quantized binary format of state values, decoded by web/js/codec.js.
+ *
+ * A value holds N items of the same type: a vector of dimension D, a
+ * quaternion, or a pose made of both. A single Eigen::Vector3d is N = 1 and
+ * D = 3, and a whole fleet of robot positions is N robots with D = 3. The
+ * buffer starts with a 24-byte little-endian header:
+ *
+ *     0  uint8[4] magic "\xffRGQ"
+ *     4  uint8    version
+ *     5  uint8    type (CodecType)
+ *     6  uint8    bits of each vector element (16 or 32), or 0
+ *     7  uint8    bits of each quaternion component (10 or 20), or 0
+ *     8  uint32   number of items N
+ *     12 uint32   vector dimension D, or 0
+ *     16 float64  resolution of the vector elements
+ *
+ * followed by the vector block and then the quaternion block:
+ *
+ * - Vector elements are signed fixed-point integers in units of the
+ *   resolution, stored item by item, and saturate at the integer limits. The
+ *   block is zero-padded to a multiple of 8 bytes.
+ * - Quaternions use smallest-three quantization: the largest component is
+ *   dropped (after flipping the sign so it is positive) and the other three,
+ *   which lie in [-1/sqrt(2), 1/sqrt(2)], are mapped linearly to the
+ *   integers [0, 2^bits - 2]. Each quaternion is one uint32 word (10 bits) or
+ *   uint64 word (20 bits) holding the index of the largest component in bits
+ *   0-1, followed by the three remaining components in xyzw order.
+ *
+ * Keys without this header are parsed as text, so both formats can be mixed.
+ */
+constexpr char kCodecMagic[4] = {'\xff', 'R', 'G', 'Q'};
+constexpr uint8_t kCodecVersion = 1;
+constexpr size_t kCodecHeaderSize = 24;
+
+enum class CodecType : uint8_t { kVectors = 1, kQuaternions = 2, kPoses = 3 };
+
+/**
+ * Precision of the quantized values.
+ *
+ * The defaults give 10 um steps over +/- 21 km for vectors and rotation errors
+ * of at most about 4e-3 rad for quaternions (4e-6 rad with 20 bits). Joint
+ * positions typically fit in 16 bits with a resolution of 1e-4 rad.
+ */
+struct CodecPrecision {
+  // Step of the fixed-point vector elements.
+  double resolution = 1e-5;
+
+  // Bits of each vector element (16 or 32).
+  uint8_t vector_bits = 32;
+
+  // Bits of each smallest-three quaternion component (10 or 20).
+  uint8_t quaternion_bits = 10;
+};
+
+/**
+ * Value decoded from the quantized format.
+ */
+struct CodecValue {
+  CodecType type = CodecType::kVectors;
+
+  // D x N vectors (positions of poses).
+  Eigen::MatrixXd vectors;
+
+  // 4 x N quaternion coefficients in xyzw order.
+  Eigen::Matrix4Xd quaternions;
+};
+
+namespace internal {
+
+inline void CheckPrecision(const CodecPrecision& precision, bool vectors,
+                           bool quaternions) {
+  if (vectors && !(precision.resolution > 0.)) {
+    throw std::invalid_argument(
+        "CodecPrecision: resolution must be positive.");
+  }
+  if (vectors && precision.vector_bits != 16 && precision.vector_bits != 32) {
+    throw std::invalid_argument(
+        "CodecPrecision: vector_bits must be 16 or 32.");
+  }
+  if (quaternions && precision.quaternion_bits != 10 &&
+      precision.quaternion_bits != 20) {
+    throw std::invalid_argument(
+        "CodecPrecision: quaternion_bits must be 10 or 20.");
+  }
+}
+
+inline size_t PadToWord(size_t num_bytes) { return (num_bytes + 7) & ~7; }
+
+/**
+ * Resizes the buffer to hold the header and blocks, and writes the header.
+ */
+inline char* ResizeCodecBuffer(CodecType type, size_t num_items, size_t dim,
+                               const CodecPrecision& precision,
+                               std::string* buffer) {
+  const bool has_vectors = type != CodecType::kQuaternions;
+  const bool has_quaternions = type != CodecType::kVectors;
+  CheckPrecision(precision, has_vectors, has_quaternions);
+
+  const uint8_t vector_bits = has_vectors ? precision.vector_bits : 0;
+  const uint8_t quaternion_bits =
+      has_quaternions ? precision.quaternion_bits : 0;
+  const size_t num_bytes_vectors =
+      PadToWord(num_items * dim * vector_bits / 8);
+  const size_t num_bytes_quaternions =
+      num_items * (quaternion_bits == 10 ? 4 : 8) * has_quaternions;
+  buffer->resize(kCodecHeaderSize + num_bytes_vectors + num_bytes_quaternions);
+
+  char* data = &(*buffer)[0];
+  std::memset(data, 0, kCodecHeaderSize + num_bytes_vectors);
+  std::memcpy(data, kCodecMagic, sizeof(kCodecMagic));
+  data[4] = static_cast<char>(kCodecVersion);
+  data[5] = static_cast<char>(type);
+  data[6] = static_cast<char>(vector_bits);
+  data[7] = static_cast<char>(quaternion_bits);
+  const uint32_t num_items_u32 = static_cast<uint32_t>(num_items);
+  const uint32_t dim_u32 = static_cast<uint32_t>(has_vectors ? dim : 0);
+  std::memcpy(data + 8, &num_items_u32, sizeof(num_items_u32));
+  std::memcpy(data + 12, &dim_u32, sizeof(dim_u32));
+  std::memcpy(data + 16, &precision.resolution, sizeof(double));
+  return data + kCodecHeaderSize;
+}
+
+/**
+ * Writes the fixed-point vector elements. The whole block is quantized with
+ * one Eigen array expression, which vectorizes across items.
+ */
+template <typename Scalar, typename Derived>
+inline void WriteFixedPoint(const Eigen::DenseBase<Derived>& values,
+                            double resolution, char* data) {
+  constexpr double kMin = std::numeric_limits<Scalar>::min();
+  constexpr double kMax = std::numeric_limits<Scalar>::max();
+  Eigen::Map<Eigen::Array<Scalar, Eigen::Dynamic, Eigen::Dynamic>> block(
+      reinterpret_cast<Scalar*>(data), values.rows(), values.cols());
+  block = (values.derived().array().template cast<double>() / resolution)
+              .round()
+              .max(kMin)
+              .min(kMax)
+              .template cast<Scalar>();
+}
+
+template <typename Derived>
+inline char* WriteVectors(const Eigen::DenseBase<Derived>& vectors,
+                          const CodecPrecision& precision, char* data) {
+  if (precision.vector_bits == 16) {
+    WriteFixedPoint<int16_t>(vectors, precision.resolution, data);
+  } else {
+    WriteFixedPoint<int32_t>(vectors, precision.resolution, data);
+  }
+  return data + PadToWord(vectors.size() * precision.vector_bits / 8);
+}
+
+/**
+ * Writes the smallest-three quaternion words of the 4 x N coefficients.
+ */
+template <typename Derived>
+inline void WriteQuaternions(const Eigen::DenseBase<Derived>& coeffs,
+                             uint8_t bits, char* data) {
+  const Eigen::Index num_items = coeffs.cols();
+  const Eigen::Array4Xd quaternions =
+      coeffs.derived().array().template cast<double>();
+
+  // Find the largest component of each quaternion and the scale that
+  // normalizes it, flips its sign to positive, and maps the other components
+  // from [-1/sqrt(2), 1/sqrt(2)] to [-1, 1].
+  Eigen::Array<uint64_t, 1, Eigen::Dynamic> idx_max(num_items);
+  Eigen::Array<double, 1, Eigen::Dynamic> scale(num_items);
+  for (Eigen::Index i = 0; i < num_items; i++) {
+    Eigen::Index idx;
+    quaternions.col(i).abs().maxCoeff(&idx);
+    const double norm = quaternions.col(i).matrix().norm();
+    idx_max(i) = static_cast<uint64_t>(idx);
+    scale(i) = (quaternions(idx, i) < 0. ? -std::sqrt(2.) : std::sqrt(2.)) /
+               (norm > 0. ? norm : 1.);
+  }
+
+  // Quantize all components at once. The step count is even so that zero is
+  // exact.
+  const double max = static_cast<double>((uint64_t(1) << bits) - 2);
+  const Eigen::Array<uint64_t, 4, Eigen::Dynamic> quantized =
+      ((quaternions.rowwise() * scale + 1.) * (0.5 * max))
+          .round()
+          .max(0.)
+          .min(max)
+          .template cast<uint64_t>();
+
+  // Pack the three smallest components after the index
+  for (Eigen::Index i = 0; i < num_items; i++) {
+    uint64_t word = idx_max(i);
+    int shift = 2;
+    for (Eigen::Index j = 0; j < 4; j++) {
+      if (static_cast<uint64_t>(j) == idx_max(i)) continue;
+      word |= quantized(j, i) << shift;
+      shift += bits;
+    }
+    if (bits == 10) {
+      const uint32_t word_u32 = static_cast<uint32_t>(word);
+      std::memcpy(data + 4 * i, &word_u32, sizeof(word_u32));
+    } else {
+      std::memcpy(data + 8 * i, &word, sizeof(word));
+    }
+  }
+}
+
+}  // namespace internal
+
+/**
+ * Encodes D x N vectors, e.g. a single Eigen::VectorXd of joint positions or
+ * the 3 x N positions of a fleet.
+ */
+template <typename Derived>
+inline void EncodeVectors(const Eigen::DenseBase<Derived>& vectors,
+                          const CodecPrecision& precision,
+                          std::string* buffer) {
+  char* data = internal::ResizeCodecBuffer(CodecType::kVectors, vectors.cols(),
+                                           vectors.rows(), precision, buffer);
+  internal::WriteVectors(vectors, precision, data);
+}
+
+/**
+ * Encodes the 4 x N coefficients (xyzw order) of a batch of quaternions.
+ */
+template <typename Derived>
+inline void EncodeQuaternions(const Eigen::DenseBase<Derived>& coeffs,
+                              const CodecPrecision& precision,
+                              std::string* buffer) {
+  char* data = internal::ResizeCodecBuffer(
+      CodecType::kQuaternions, coeffs.cols(), 0, precision, buffer);
+  internal::WriteQuaternions(coeffs, precision.quaternion_bits, data);
+}
+
+inline void EncodeQuaternions(const std::vector<Eigen::Quaterniond>& quats,
+                              const CodecPrecision& precision,
+                              std::string* buffer) {
+  // Quaterniond stores its coefficients contiguously in xyzw order.
+  const Eigen::Map<const Eigen::Matrix4Xd> coeffs(
+      quats.empty() ? nullptr : quats.front().coeffs().data(), 4,
+      quats.size());
+  EncodeQuaternions(coeffs, precision, buffer);
+}
+
+inline void EncodeQuaternion(const Eigen::Quaterniond& quat,
+                             const CodecPrecision& precision,
+                             std::string* buffer) {
+  EncodeQuaternions(quat.coeffs(), precision, buffer);
+}
+
+/**
+ * Encodes a batch of poses from their 3 x N positions and 4 x N quaternion
+ * coefficients.
+ */
+template <typename DerivedPos, typename DerivedOri>
+inline void EncodePoses(const Eigen::DenseBase<DerivedPos>& positions,
+                        const Eigen::DenseBase<DerivedOri>& coeffs,
+                        const CodecPrecision& precision, std::string* buffer) {
+  if (positions.rows() != 3 || coeffs.rows() != 4 ||
+      positions.cols() != coeffs.cols()) {
+    throw std::invalid_argument(
+        "EncodePoses(): expected 3 x N positions and 4 x N quaternions.");
+  }
+  char* data = internal::ResizeCodecBuffer(
+      CodecType::kPoses, positions.cols(), 3, precision, buffer);
+  data = internal::WriteVectors(positions, precision, data);
+  internal::WriteQuaternions(coeffs, precision.quaternion_bits, data);
+}
+
+inline void EncodeIsometries(const std::vector<Eigen::Isometry3d>& poses,
+                             const CodecPrecision& precision,
+                             std::string* buffer) {
+  Eigen::Matrix3Xd positions(3, poses.size());
+  Eigen::Matrix4Xd coeffs(4, poses.size());
+  for (size_t i = 0; i < poses.size(); i++) {
+    positions.col(i) = poses[i].translation();
+    coeffs.col(i) = Eigen::Quaterniond(poses[i].linear()).coeffs();
+  }
+  EncodePoses(positions, coeffs, precision, buffer);
+}
+
+inline void EncodeIsometry(const Eigen::Isometry3d& pose,
+                           const CodecPrecision& precision,
+                           std::string* buffer) {
+  EncodePoses(pose.translation(),
+              Eigen::Quaterniond(pose.linear()).coeffs(), precision, buffer);
+}
+
+/**
+ * Returns whether the value is in the quantized format rather than text.
+ */
+inline bool IsEncoded(std::string_view value) {
+  return value.size() >= kCodecHeaderSize &&
+         value.compare(0, sizeof(kCodecMagic),
+                       std::string_view(kCodecMagic, sizeof(kCodecMagic))) ==
+             0;
+}
+
+/**
+ * Decodes a value in the quantized format.
+ *
+ * @throws std::invalid_argument if the value is not in the format.
+ */
+inline CodecValue Decode(std::string_view value) {
+  if (!IsEncoded(value) || static_cast<uint8_t>(value[4]) != kCodecVersion) {
+    throw std::invalid_argument("Decode(): unrecognized value.");
+  }
+  const char* data = value.data();
+  const CodecType type = static_cast<CodecType>(data[5]);
+  const uint8_t vector_bits = static_cast<uint8_t>(data[6]);
+  const uint8_t quaternion_bits = static_cast<uint8_t>(data[7]);
+  uint32_t num_items;
+  uint32_t dim;
+  double resolution;
+  std::memcpy(&num_items, data + 8, sizeof(num_items));
+  std::memcpy(&dim, data + 12, sizeof(dim));
+  std::memcpy(&resolution, data + 16, sizeof(resolution));
+
+  const bool has_vectors = type != CodecType::kQuaternions;
+  const bool has_quaternions = type != CodecType::kVectors;
+  if (type != CodecType::kVectors && type != CodecType::kQuaternions &&
+      type != CodecType::kPoses) {
+    throw std::invalid_argument("Decode(): unrecognized type.");
+  }
+  CodecPrecision precision;
+  precision.resolution = resolution;
+  precision.vector_bits = vector_bits;
+  precision.quaternion_bits = quaternion_bits;
+  internal::CheckPrecision(precision, has_vectors, has_quaternions);
+
+  const size_t num_bytes_vectors = internal::PadToWord(
+      static_cast<size_t>(num_items) * dim * vector_bits / 8);
+  const size_t num_bytes_word = quaternion_bits == 10 ? 4 : 8;
+  const size_t num_bytes_quaternions =
+      has_quaternions ? num_items * num_bytes_word : 0;
+  if (value.size() <
+      kCodecHeaderSize + num_bytes_vectors + num_bytes_quaternions) {
+    throw std::invalid_argument("Decode(): value is truncated.");
+  }
+
+  CodecValue decoded;
+  decoded.type = type;
+  data += kCodecHeaderSize;
+  if (has_vectors) {
+    decoded.vectors.resize(dim, num_items);
+    for (Eigen::Index i = 0; i < decoded.vectors.size(); i++) {
+      if (vector_bits == 16) {
+        int16_t element;
+        std::memcpy(&element, data + sizeof(element) * i, sizeof(element));
+        decoded.vectors(i) = resolution * element;
+      } else {
+        int32_t element;
+        std::memcpy(&element, data + sizeof(element) * i, sizeof(element));
+        decoded.vectors(i) = resolution * element;
+      }
+    }
+    data += num_bytes_vectors;
+  }
+  if (has_quaternions) {
+    decoded.quaternions.resize(4, num_items);
+    const uint64_t mask = (uint64_t(1) << quaternion_bits) - 1;
+    const double max = static_cast<double>(mask - 1);
+    for (uint32_t i = 0; i < num_items; i++) {
+      uint64_t word = 0;
+      std::memcpy(&word, data + num_bytes_word * i, num_bytes_word);
+      const Eigen::Index idx_max = static_cast<Eigen::Index>(word & 3);
+      int shift = 2;
+      double sum_squares = 0.;
+      for (Eigen::Index j = 0; j < 4; j++) {
+        if (j == idx_max) continue;
+        const double c = ((word >> shift) & mask) / max * 2. - 1.;
+        decoded.quaternions(j, i) = c / std::sqrt(2.);
+        sum_squares += 0.5 * c * c;
+        shift += quaternion_bits;
+      }
+      decoded.quaternions(idx_max, i) =
+          std::sqrt(sum_squares < 1. ? 1. - sum_squares : 0.);
+    }
+  }
+  return decoded;
+}
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_CODEC_H_
@@ -0,0 +1,92 @@
+/**
+ * format.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_FORMAT_H_
+#define REDIS_GL_FORMAT_H_
+
+// std
+#include <charconv>  // std::to_chars
+#include <string>    // std::string
+
+// external
+#include <Eigen/Core>
+
+namespace redis_gl {
+
+namespace simulator {
+
+namespace internal {
+
+/**
+ * Appends a number to the buffer using the shortest round-trip representation.
+ */
+inline void AppendNumber(double value, std::string* buffer) {
+  char str[32];
+  const std::to_chars_result result =
+      std::to_chars(str, str + sizeof(str), value);
+  buffer->append(str, result.ptr);
+}
+
+/**
+ * Appends a matrix in the text format parsed by the browser: elements are
+ * separated by spaces and rows by semicolons.
+ */
+template <typename Derived>
+inline void AppendMatrix(const Eigen::DenseBase<Derived>& matrix,
+                         std::string* buffer) {
+  // Vectors are always written as a single row.
+  const bool is_vector = matrix.cols() == 1;
+  const Eigen::Index rows = is_vector ? 1 : matrix.rows();
+  const Eigen::Index cols = is_vector ? matrix.rows() : matrix.cols();
+  for (Eigen::Index i = 0; i < rows; i++) {
+    if (i > 0) buffer->append("; ");
+    for (Eigen::Index j = 0; j < cols; j++) {
+      if (j > 0) buffer->push_back(' ');
+      AppendNumber(is_vector ? matrix(j, 0) : matrix(i, j), buffer);
+    }
+  }
+}
+
+/**
+ * Appends a string to the buffer as a quoted json string.
+ */
+inline void AppendJsonString(const std::string& str, std::string* buffer) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  buffer->push_back('"');
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        buffer->append("\\\"");
+        break;
+      case '\\':
+        buffer->append("\\\\");
+        break;
+      case '\n':
+        buffer->append("\\n");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          buffer->append("\\u00");
+          buffer->push_back(kHex[(c >> 4) & 0xf]);
+          buffer->push_back(kHex[c & 0xf]);
+        } else {
+          buffer->push_back(c);
+        }
+    }
+  }
+  buffer->push_back('"');
+}
+
+}  // namespace internal
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_FORMAT_H_
@@ -0,0 +1,320 @@
+/**
+ * frame_publisher.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_FRAME_PUBLISHER_H_
+#define REDIS_GL_FRAME_PUBLISHER_H_
+
+#include "redis_gl/format.h"
+#include "redis_gl/latency.h"
+#include "redis_gl/robot.h"
+
+// std
+#include <chrono>         // std::chrono
+#include <cstdint>        // uint64_t
+#include <string>         // std::string
+#include <unordered_map>  // std::unordered_map
+#include <utility>        // std::pair
+#include <vector>         // std::vector
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Collects the state of all registered models for one control tick and
+ * publishes it as a single atomic frame.
+ *
+ * Each call to Publish() sends one MSET command containing the frame key
+ * `<namespace>::frame` and, optionally, the individual state keys. Because
+ * MSET is atomic, Redis readers never observe a partially written tick. The
+ * frame key holds a json object of the form
+ * `{"epoch": <publisher id>, "id": <frame id>, "values": {<key>: <val>}}`, and
+ * the viewer applies its values all at once, skipping stale or out-of-order
+ * frames.
+ *
+ * Each frame also sets the latency stamp of the "frame" family (see
+ * LatencyStamper) so that the server can report controller-to-browser
+ * latency and dropped frames. In addition, each family with values in the
+ * frame is stamped separately: "robot" for SetRobot(), "object" for
+ * SetObject(), "camera" for SetCamera(), and the family passed to Set(), so
+ * that the latency of e.g. robot joint positions and object poses can be told
+ * apart.
+ *
+ * Example:
+ *
+ *     FramePublisher publisher(model_keys);
+ *     while (true) {
+ *       publisher.SetRobot(robot);
+ *       publisher.SetObject(object, pos, quat);
+ *       publisher.Publish(redis);
+ *     }
+ */
+class FramePublisher {
+ public:
+  /**
+   * @param model_keys Namespace of the registered models.
+   * @param write_state_keys Also set the individual state keys (e.g.
+   *                         `key_q`) so that other Redis clients can read
+   *                         them.
+   * @param stamp_latency Set a latency stamp with every frame.
+   */
+  explicit FramePublisher(const ModelKeys& model_keys,
+                          bool write_state_keys = true,
+                          bool stamp_latency = true)
+      : model_keys_(model_keys),
+        key_frame_(model_keys.key_frame),
+        write_state_keys_(write_state_keys),
+        stamp_latency_(stamp_latency),
+        latency_stamper_(stamp_latency ? LatencyStamper(model_keys, "frame")
+                                       : LatencyStamper()),
+        epoch_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count()) {
+    idx_family_robot_ = FamilyIndex("robot");
+    idx_family_object_ = FamilyIndex("object");
+    idx_family_camera_ = FamilyIndex("camera");
+  }
+
+  /**
+   * Stages the joint positions and base pose of a robot for the next frame.
+   */
+  void SetRobot(const RobotModel& robot) {
+    const spatial_dyn::ArticulatedBody& ab = *robot.articulated_body;
+    SetFamily(robot.key_q, ab.q(), idx_family_robot_);
+    if (!robot.key_pos.empty()) {
+      SetFamily(robot.key_pos, ab.T_base_to_world().translation(),
+                idx_family_robot_);
+    }
+    if (!robot.key_ori.empty()) {
+      SetFamily(robot.key_ori,
+                Eigen::Quaterniond(ab.T_base_to_world().linear()).coeffs(),
+                idx_family_robot_);
+    }
+  }
+
+  /**
+   * Stages the pose of an object for the next frame.
+   */
+  void SetObject(const ObjectModel& object, const Eigen::Vector3d& pos,
+                 const Eigen::Quaterniond& quat) {
+    SetFamily(object.key_pos, pos, idx_family_object_);
+    if (!object.key_ori.empty()) {
+      SetFamily(object.key_ori, quat.coeffs(), idx_family_object_);
+    }
+  }
+
+  /**
+   * Stages the pose of a camera for the next frame.
+   */
+  void SetCamera(const CameraModel& camera, const Eigen::Vector3d& pos,
+                 const Eigen::Quaterniond& quat) {
+    SetFamily(camera.key_pos, pos, idx_family_camera_);
+    SetFamily(camera.key_ori, quat.coeffs(), idx_family_camera_);
+  }
+
+  /**
+   * Stages an arbitrary Eigen value for the next frame.
+   *
+   * @param family Latency stamp family of the value, or empty for none.
+   */
+  template <typename Derived>
+  void Set(const std::string& key, const Eigen::DenseBase<Derived>& value,
+           const std::string& family = "") {
+    SetFamily(key, value, FamilyIndex(family));
+  }
+
+  /**
+   * Stages a quaternion for the next frame in xyzw order.
+   */
+  void Set(const std::string& key, const Eigen::Quaterniond& quat,
+           const std::string& family = "") {
+    SetFamily(key, quat.coeffs(), FamilyIndex(family));
+  }
+
+  /**
+   * Stages a preformatted string value for the next frame.
+   */
+  void Set(const std::string& key, const std::string& value,
+           const std::string& family = "") {
+    if (key.empty()) return;
+    Stage(key, FamilyIndex(family)) = value;
+  }
+
+  /**
+   * Publishes all values staged since the last call as one frame.
+   *
+   * @param redis Redis client.
+   * @param commit Commit the mset command (asynchronously).
+   * @return Id of the published frame, or 0 if nothing was staged.
+   */
+  uint64_t Publish(ctrl_utils::RedisClient& redis, bool commit = true) {
+    if (staged_.empty()) return 0;
+    frame_id_++;
+
+    // Serialize frame
+    frame_.clear();
+    frame_.append("{\"epoch\":");
+    frame_.append(std::to_string(epoch_));
+    frame_.append(",\"id\":");
+    frame_.append(std::to_string(frame_id_));
+    frame_.append(",\"values\":{");
+    for (size_t i = 0; i < staged_.size(); i++) {
+      const Slot& slot = slots_[staged_[i]];
+      if (i > 0) frame_.push_back(',');
+      internal::AppendJsonString(slot.key, &frame_);
+      frame_.push_back(':');
+      internal::AppendJsonString(slot.val, &frame_);
+    }
+    frame_.append("}}");
+
+    // Build mset command
+    command_.clear();
+    command_.push_back("MSET");
+    if (write_state_keys_) {
+      for (const size_t idx : staged_) {
+        command_.push_back(slots_[idx].key);
+        command_.push_back(slots_[idx].val);
+      }
+    }
+    command_.push_back(key_frame_);
+    command_.push_back(frame_);
+    if (!latency_stamper_.key().empty()) {
+      command_.push_back(latency_stamper_.key());
+      command_.push_back(latency_stamper_.Next());
+    }
+    for (Family& family : families_) {
+      if (!family.staged) continue;
+      family.staged = false;
+      if (family.stamper.key().empty()) continue;
+      command_.push_back(family.stamper.key());
+      command_.push_back(family.stamper.Next());
+    }
+    redis.send(command_, [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+
+    for (const size_t idx : staged_) slots_[idx].staged = false;
+    staged_.clear();
+    return frame_id_;
+  }
+
+  /**
+   * Takes the values staged since the last call as a frame without sending
+   * them, e.g. to stream them with StreamServer.
+   *
+   * @param key_vals Output of the staged keys and values.
+   * @return Id of the frame, or 0 if nothing was staged.
+   */
+  uint64_t TakeFrame(
+      std::vector<std::pair<std::string, std::string>>* key_vals) {
+    key_vals->clear();
+    if (staged_.empty()) return 0;
+    frame_id_++;
+    for (const size_t idx : staged_) {
+      key_vals->emplace_back(slots_[idx].key, slots_[idx].val);
+      slots_[idx].staged = false;
+    }
+    staged_.clear();
+    for (Family& family : families_) family.staged = false;
+    return frame_id_;
+  }
+
+  /**
+   * Id of the last published frame.
+   */
+  uint64_t frame_id() const { return frame_id_; }
+
+  const std::string& key_frame() const { return key_frame_; }
+
+ private:
+  // Index of values that belong to no latency stamp family.
+  static constexpr size_t kNoFamily = static_cast<size_t>(-1);
+
+  struct Slot {
+    std::string key;
+    std::string val;
+    bool staged = false;
+  };
+
+  struct Family {
+    LatencyStamper stamper;
+
+    // Whether a value of the family is staged in the next frame.
+    bool staged = false;
+  };
+
+  /**
+   * Returns the index of a latency stamp family, adding it on first use.
+   */
+  size_t FamilyIndex(const std::string& family) {
+    if (family.empty()) return kNoFamily;
+    auto it = idx_families_.find(family);
+    if (it != idx_families_.end()) return it->second;
+
+    idx_families_.emplace(family, families_.size());
+    families_.push_back({stamp_latency_ ? LatencyStamper(model_keys_, family)
+                                        : LatencyStamper(),
+                         false});
+    return families_.size() - 1;
+  }
+
+  template <typename Derived>
+  void SetFamily(const std::string& key, const Eigen::DenseBase<Derived>& value,
+                 size_t idx_family) {
+    if (key.empty()) return;
+    std::string& val = Stage(key, idx_family);
+    internal::AppendMatrix(value, &val);
+  }
+
+  /**
+   * Returns the cleared value buffer for the key, reusing its slot from
+   * previous frames.
+   */
+  std::string& Stage(const std::string& key, size_t idx_family) {
+    auto it = idx_slots_.find(key);
+    if (it == idx_slots_.end()) {
+      it = idx_slots_.emplace(key, slots_.size()).first;
+      slots_.push_back({key, "", false});
+    }
+    Slot& slot = slots_[it->second];
+    if (!slot.staged) {
+      slot.staged = true;
+      staged_.push_back(it->second);
+    }
+    if (idx_family != kNoFamily) families_[idx_family].staged = true;
+    slot.val.clear();
+    return slot.val;
+  }
+
+  ModelKeys model_keys_;
+  std::string key_frame_;
+  bool write_state_keys_;
+  bool stamp_latency_;
+  LatencyStamper latency_stamper_;
+  int64_t epoch_;
+  uint64_t frame_id_ = 0;
+
+  std::vector<Family> families_;
+  std::unordered_map<std::string, size_t> idx_families_;
+  size_t idx_family_robot_;
+  size_t idx_family_object_;
+  size_t idx_family_camera_;
+
+  std::vector<Slot> slots_;
+  std::unordered_map<std::string, size_t> idx_slots_;
+  std::vector<size_t> staged_;
+
+  std::string frame_;
+  std::vector<std::string> command_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_FRAME_PUBLISHER_H_
@@ -0,0 +1,160 @@
+/**
+ * interaction_reader.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_INTERACTION_READER_H_
+#define REDIS_GL_INTERACTION_READER_H_
+
+#include "redis_gl/redis_gl.h"
+#include "redis_gl/triple_buffer.h"
+
+// std
+#include <atomic>     // std::atomic
+#include <chrono>     // std::chrono
+#include <cstdint>    // uint64_t
+#include <exception>  // std::exception
+#include <future>     // std::future, std::future_status
+#include <string>     // std::string
+#include <thread>     // std::thread
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Polls the web app interaction key in a background thread so that real-time
+ * control loops never block on Redis or parse json.
+ *
+ * The background thread only parses the interaction when its raw value
+ * changes. Each change increments a sequence number and is handed to the
+ * control thread through a wait-free triple buffer. Deleting the key resets
+ * the interaction to its default.
+ *
+ * Example:
+ *
+ *     ctrl_utils::RedisClient redis_interaction;
+ *     redis_interaction.connect();
+ *     InteractionReader interaction_reader(redis_interaction);
+ *
+ *     while (true) {
+ *       // Wait-free, allocation-free
+ *       interaction_reader.Update();
+ *       const RealtimeInteraction& interaction =
+ *           interaction_reader.interaction();
+ *       ClickAdjustPose(interaction, &pos, &quat);
+ *     }
+ */
+class InteractionReader {
+ public:
+  /**
+   * Starts the background thread.
+   *
+   * @param redis Connected Redis client used exclusively by the background
+   *              thread.
+   * @param period Polling period.
+   */
+  explicit InteractionReader(
+      ctrl_utils::RedisClient& redis,
+      std::chrono::microseconds period = std::chrono::milliseconds(1))
+      : redis_(redis),
+        period_(period),
+        thread_(&InteractionReader::Run, this) {}
+
+  ~InteractionReader() {
+    running_ = false;
+    thread_.join();
+  }
+
+  InteractionReader(const InteractionReader&) = delete;
+  InteractionReader& operator=(const InteractionReader&) = delete;
+
+  /**
+   * Fetches the latest interaction from the background thread.
+   *
+   * This function is wait-free and does not allocate memory.
+   *
+   * @return True if the interaction changed since the last call.
+   */
+  bool Update() { return buffer_.Update(); }
+
+  /**
+   * Latest interaction fetched by Update().
+   */
+  const RealtimeInteraction& interaction() const {
+    return buffer_.front().interaction;
+  }
+
+  /**
+   * Change sequence number of the latest interaction fetched by Update(). The
+   * sequence number is 0 until the first interaction is read from Redis.
+   */
+  uint64_t sequence() const { return buffer_.front().sequence; }
+
+ private:
+  struct Slot {
+    RealtimeInteraction interaction;
+    uint64_t sequence = 0;
+  };
+
+  void Run() {
+    std::string str_interaction;
+    uint64_t sequence = 0;
+
+    auto t_next = std::chrono::steady_clock::now();
+    while (running_) {
+      std::future<cpp_redis::reply> fut_reply =
+          redis_.send({"GET", KEY_INTERACTION});
+      redis_.commit();
+
+      // Wait in steps so the destructor can stop an unresponsive connection
+      while (running_ &&
+             fut_reply.wait_for(period_) != std::future_status::ready) {}
+      if (!running_) break;
+      const cpp_redis::reply reply = fut_reply.get();
+
+      // Reset the interaction once the key is deleted
+      if (reply.is_null() && !str_interaction.empty()) {
+        str_interaction.clear();
+        Slot& slot = buffer_.back();
+        slot.interaction = RealtimeInteraction();
+        slot.sequence = ++sequence;
+        buffer_.Publish();
+      }
+
+      // Only parse the interaction when it changes
+      if (reply.is_string() && reply.as_string() != str_interaction) {
+        str_interaction = reply.as_string();
+        try {
+          const Interaction interaction =
+              nlohmann::json::parse(str_interaction).get<Interaction>();
+          Slot& slot = buffer_.back();
+          slot.interaction = RealtimeInteraction(interaction);
+          slot.sequence = ++sequence;
+          buffer_.Publish();
+        } catch (const std::exception&) {
+          // Ignore malformed interactions until the key is set again.
+        }
+      }
+
+      t_next += period_;
+      std::this_thread::sleep_until(t_next);
+    }
+  }
+
+  ctrl_utils::RedisClient& redis_;
+  std::chrono::microseconds period_;
+  TripleBuffer<Slot> buffer_;
+  std::atomic<bool> running_ = {true};
+  std::thread thread_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_INTERACTION_READER_H_
@@ -0,0 +1,202 @@
+/**
+ * latency.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_LATENCY_H_
+#define REDIS_GL_LATENCY_H_
+
+#include "redis_gl/redis_gl.h"
+
+// std
+#include <chrono>     // std::chrono
+#include <cstdint>    // int64_t, uint64_t
+#include <exception>  // std::current_exception
+#include <future>     // std::future, std::promise
+#include <map>        // std::map
+#include <memory>     // std::make_shared
+#include <string>     // std::string
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Writes latency stamps for one key family (e.g. "robot" or "camera_image").
+ *
+ * A stamp is the key `<namespace>::latency::stamp::<family>` with the value
+ * "<sequence> <time>", where time is std::chrono::steady_clock in
+ * nanoseconds. On Linux this is CLOCK_MONOTONIC, the same clock as Python's
+ * time.monotonic_ns(), so the server can compute the controller-to-server
+ * latency as long as both run on the same host.
+ *
+ * The server measures each hop of a stamp (controller to RedisMonitor,
+ * RedisMonitor to WebSocket, WebSocket to browser render) and counts gaps in
+ * the sequence numbers as dropped frames. The results are written to
+ * `ModelKeys::key_latency` and can be read back with GetLatencyReport().
+ *
+ * Example:
+ *
+ *     LatencyStamper stamper(model_keys, "camera_image");
+ *     image_publisher.PublishDepth(redis, camera, depth.data(), 480, 640);
+ *     stamper.Stamp(redis);
+ *     redis.commit();
+ */
+class LatencyStamper {
+ public:
+  LatencyStamper() = default;
+
+  LatencyStamper(const ModelKeys& model_keys, const std::string& family)
+      : key_(model_keys.key_latency_stamps_prefix + family) {}
+
+  /**
+   * Advances the sequence number and formats a new stamp value.
+   *
+   * @return Stamp value, valid until the next call.
+   */
+  const std::string& Next() {
+    const int64_t t = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+    sequence_++;
+    val_ = std::to_string(sequence_);
+    val_.push_back(' ');
+    val_.append(std::to_string(t));
+    return val_;
+  }
+
+  /**
+   * Sets a new stamp. Send this right after the stamped data so that both
+   * are in the same pipeline.
+   */
+  void Stamp(ctrl_utils::RedisClient& redis, bool commit = false) {
+    if (key_.empty()) return;
+    redis.send({"SET", key_, Next()}, [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+  }
+
+  const std::string& key() const { return key_; }
+
+  /**
+   * Sequence number of the last stamp.
+   */
+  uint64_t sequence() const { return sequence_; }
+
+ private:
+  std::string key_;
+  std::string val_;
+  uint64_t sequence_ = 0;
+};
+
+/**
+ * Latency statistics of one hop in milliseconds.
+ */
+struct LatencyStats {
+  // Number of samples in the window (the last 1000 by default).
+  size_t count = 0;
+
+  // Number of dropped stamps since the server started.
+  size_t dropped = 0;
+
+  double p50 = 0.;
+  double p99 = 0.;
+  double max = 0.;
+};
+
+inline void from_json(const nlohmann::json& json, LatencyStats& stats) {
+  stats.count = json.value("count", size_t{0});
+  stats.dropped = json.value("dropped", size_t{0});
+  stats.p50 = json.value("p50", 0.);
+  stats.p99 = json.value("p99", 0.);
+  stats.max = json.value("max", 0.);
+}
+
+inline void to_json(nlohmann::json& json, const LatencyStats& stats) {
+  json["count"] = stats.count;
+  json["dropped"] = stats.dropped;
+  json["p50"] = stats.p50;
+  json["p99"] = stats.p99;
+  json["max"] = stats.max;
+}
+
+/**
+ * Latency report written by the server.
+ *
+ * Hops of each family:
+ *
+ *     redis      controller stamp to RedisMonitor read, including polling
+ *     websocket  RedisMonitor read to WebSocket send, including encoding
+ *     total      controller stamp to WebSocket send
+ *     browser    WebSocket receive to render in the browser
+ *
+ * The dropped count of the redis hop counts stamps overwritten before the
+ * server read them, and that of the browser hop counts stamps the browser
+ * never rendered (including those dropped upstream).
+ */
+struct LatencyReport {
+  // Server time of the report (monotonic nanoseconds).
+  int64_t t = 0;
+
+  // Statistics per family and hop.
+  std::map<std::string, std::map<std::string, LatencyStats>> families;
+
+  /**
+   * Returns the statistics of a hop, or nullptr if none were reported.
+   */
+  const LatencyStats* Find(const std::string& family,
+                           const std::string& hop) const {
+    auto it_family = families.find(family);
+    if (it_family == families.end()) return nullptr;
+    auto it_hop = it_family->second.find(hop);
+    return it_hop == it_family->second.end() ? nullptr : &it_hop->second;
+  }
+};
+
+inline void from_json(const nlohmann::json& json, LatencyReport& report) {
+  report.t = json.value("t", int64_t{0});
+  report.families.clear();
+  if (!json.contains("families")) return;
+  for (const auto& family : json.at("families").items()) {
+    for (const auto& hop : family.value().items()) {
+      report.families[family.key()][hop.key()] =
+          hop.value().get<LatencyStats>();
+    }
+  }
+}
+
+/**
+ * Reads the latest latency report of the namespace.
+ *
+ * The report is empty if the server hasn't written one yet. Throws from the
+ * future if the report can't be parsed.
+ */
+inline std::future<LatencyReport> GetLatencyReport(
+    ctrl_utils::RedisClient& redis, const ModelKeys& model_keys,
+    bool commit = false) {
+  auto promise = std::make_shared<std::promise<LatencyReport>>();
+  redis.send({"GET", model_keys.key_latency},
+             [promise](cpp_redis::reply& reply) {
+               if (!reply.is_string()) {
+                 promise->set_value(LatencyReport());
+                 return;
+               }
+               try {
+                 promise->set_value(nlohmann::json::parse(reply.as_string())
+                                        .get<LatencyReport>());
+               } catch (...) {
+                 promise->set_exception(std::current_exception());
+               }
+             });
+  if (commit) redis.commit();
+  return promise->get_future();
+}
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_LATENCY_H_
@@ -0,0 +1,650 @@
+/**
+ * mesh.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_MESH_H_
+#define REDIS_GL_MESH_H_
+
+// std
+#include <algorithm>      // std::max, std::min, std::sort
+#include <array>          // std::array
+#include <cctype>         // std::tolower
+#include <cmath>          // std::floor, std::lround
+#include <cstdint>        // uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstdlib>        // std::strtof, std::strtol
+#include <cstring>        // std::memchr, std::memcmp, std::memcpy, std::memset
+#include <filesystem>     // std::filesystem
+#include <fstream>        // std::ifstream, std::ofstream
+#include <iterator>       // std::istreambuf_iterator
+#include <map>            // std::map
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+// external
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Compact mesh format written by PreprocessMesh().
+ *
+ * Each level of detail is a separate file that starts with a 48-byte
+ * little-endian header:
+ *
+ *     0  uint8[4]   magic "\xffRGM"
+ *     4  uint8      version
+ *     5  uint8      level of detail (0 is the coarsest)
+ *     6  uint8      number of levels of detail
+ *     7  uint8      bytes per index (2 or 4)
+ *     8  uint32     number of vertices V
+ *     12 uint32     number of triangles F
+ *     16 float32[3] minimum corner of the bounding box
+ *     28 float32[3] maximum corner of the bounding box
+ *     40 uint64     hash of the source mesh and preprocessing options
+ *
+ * followed by V uint16 xyz positions quantized to the bounding box, padded
+ * to 4 bytes, then F triangles of vertex indices.
+ */
+constexpr char kMeshMagic[4] = {'\xff', 'R', 'G', 'M'};
+constexpr uint8_t kMeshVersion = 1;
+constexpr size_t kMeshHeaderSize = 48;
+
+/**
+ * Each cache directory lists the file names of its cached meshes, one per
+ * line, so the viewer only requests levels of detail that exist.
+ */
+constexpr char kMeshIndexFilename[] = "rgm_index.txt";
+
+/**
+ * Indexed triangle mesh without normals or texture coordinates.
+ */
+struct TriangleMesh {
+  std::vector<Eigen::Vector3f> vertices;
+  std::vector<std::array<uint32_t, 3>> triangles;
+};
+
+struct MeshPreprocessOptions {
+  // Triangle budget of the finest level of detail.
+  size_t max_triangles = 50000;
+
+  // Maximum number of levels of detail, including the finest.
+  size_t num_lods = 3;
+
+  // Ratio of the triangles of each level to the next finer level.
+  double lod_ratio = 0.2;
+
+  // Coarser levels are not generated below this number of triangles.
+  size_t min_triangles = 500;
+};
+
+namespace internal {
+
+inline uint64_t HashFnv1a(const void* data, size_t size,
+                          uint64_t hash = 14695981039346656037ull) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+inline std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("ReadFile(): could not open " + path.string() +
+                             ".");
+  }
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+inline std::string ToLower(std::string str) {
+  for (char& c : str) c = static_cast<char>(std::tolower(c));
+  return str;
+}
+
+/**
+ * Welds vertices with identical coordinates, e.g. from STL triangle soup.
+ */
+class VertexWelder {
+ public:
+  explicit VertexWelder(TriangleMesh* mesh) : mesh_(mesh) {}
+
+  uint32_t Add(const Eigen::Vector3f& v) {
+    std::array<uint32_t, 3> bits;
+    std::memcpy(bits.data(), v.data(), sizeof(bits));
+    const uint64_t key = HashFnv1a(bits.data(), sizeof(bits));
+    auto it = idx_vertices_.find(key);
+    if (it != idx_vertices_.end() && mesh_->vertices[it->second] == v) {
+      return it->second;
+    }
+    const uint32_t idx = static_cast<uint32_t>(mesh_->vertices.size());
+    mesh_->vertices.push_back(v);
+    if (it == idx_vertices_.end()) idx_vertices_[key] = idx;
+    return idx;
+  }
+
+ private:
+  TriangleMesh* mesh_;
+  std::unordered_map<uint64_t, uint32_t> idx_vertices_;
+};
+
+inline void AddTriangle(uint32_t a, uint32_t b, uint32_t c,
+                        TriangleMesh* mesh) {
+  if (a == b || b == c || c == a) return;
+  mesh->triangles.push_back({a, b, c});
+}
+
+/**
+ * Grid cell of every vertex at the given resolution.
+ */
+inline void AssignCells(const TriangleMesh& mesh, const Eigen::Vector3f& origin,
+                        float cell_size, std::vector<uint64_t>* cells) {
+  cells->resize(mesh.vertices.size());
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    const Eigen::Vector3f idx = (mesh.vertices[i] - origin) / cell_size;
+    uint64_t cell = 0;
+    for (size_t j = 0; j < 3; j++) {
+      cell = (cell << 21) | static_cast<uint64_t>(std::floor(idx(j)));
+    }
+    (*cells)[i] = cell;
+  }
+}
+
+/**
+ * Upper bound on the triangles left after clustering into cells.
+ */
+inline size_t CountClusteredTriangles(const TriangleMesh& mesh,
+                                      const std::vector<uint64_t>& cells) {
+  size_t num_triangles = 0;
+  for (const std::array<uint32_t, 3>& f : mesh.triangles) {
+    const uint64_t a = cells[f[0]];
+    const uint64_t b = cells[f[1]];
+    const uint64_t c = cells[f[2]];
+    num_triangles += a != b && b != c && c != a;
+  }
+  return num_triangles;
+}
+
+/**
+ * Clusters the vertices in each cell into one vertex that minimizes the
+ * quadric error of the surrounding triangles.
+ */
+inline TriangleMesh ClusterVertices(const TriangleMesh& mesh,
+                                    const Eigen::Vector3f& origin,
+                                    float cell_size,
+                                    const std::vector<uint64_t>& cells) {
+  // Map cells to clusters
+  std::unordered_map<uint64_t, uint32_t> idx_clusters;
+  idx_clusters.reserve(mesh.vertices.size());
+  std::vector<uint32_t> clusters(mesh.vertices.size());
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    auto it = idx_clusters.emplace(cells[i], idx_clusters.size()).first;
+    clusters[i] = it->second;
+  }
+  const size_t num_clusters = idx_clusters.size();
+
+  // Accumulate area-weighted plane quadrics and vertex means
+  std::vector<Eigen::Matrix4d> quadrics(num_clusters, Eigen::Matrix4d::Zero());
+  std::vector<Eigen::Vector3d> means(num_clusters, Eigen::Vector3d::Zero());
+  std::vector<size_t> counts(num_clusters, 0);
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    means[clusters[i]] += mesh.vertices[i].cast<double>();
+    counts[clusters[i]]++;
+  }
+  for (const std::array<uint32_t, 3>& f : mesh.triangles) {
+    const Eigen::Vector3d a = mesh.vertices[f[0]].cast<double>();
+    const Eigen::Vector3d b = mesh.vertices[f[1]].cast<double>();
+    const Eigen::Vector3d c = mesh.vertices[f[2]].cast<double>();
+    const Eigen::Vector3d n = (b - a).cross(c - a);
+    const double area = 0.5 * n.norm();
+    if (area <= 0.) continue;
+    Eigen::Vector4d plane;
+    plane << n / n.norm(), -n.dot(a) / n.norm();
+    const Eigen::Matrix4d Q = area * plane * plane.transpose();
+    for (const uint32_t idx : f) quadrics[clusters[idx]] += Q;
+  }
+
+  // Solve for the minimizer around the mean with a pseudo-inverse, and keep
+  // it inside the cell
+  TriangleMesh result;
+  result.vertices.resize(num_clusters);
+  for (const auto& key_val : idx_clusters) {
+    const uint32_t idx = key_val.second;
+    const Eigen::Vector3d mean = means[idx] / static_cast<double>(counts[idx]);
+    const Eigen::Matrix3d A = quadrics[idx].topLeftCorner<3, 3>();
+    const Eigen::Vector3d b = quadrics[idx].topRightCorner<3, 1>();
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig(A);
+    const Eigen::Vector3d& lambda = eig.eigenvalues();
+    const double lambda_min = 1e-3 * lambda.cwiseAbs().maxCoeff();
+    Eigen::Vector3d lambda_inv = Eigen::Vector3d::Zero();
+    for (size_t j = 0; j < 3; j++) {
+      if (lambda(j) > lambda_min) lambda_inv(j) = 1. / lambda(j);
+    }
+    const Eigen::Matrix3d& V = eig.eigenvectors();
+    Eigen::Vector3d x = mean - V * lambda_inv.asDiagonal() *
+                                   V.transpose() * (A * mean + b);
+
+    Eigen::Vector3d cell_min;
+    for (size_t j = 0; j < 3; j++) {
+      const uint64_t idx_cell = (key_val.first >> (21 * (2 - j))) & 0x1fffff;
+      cell_min(j) = origin(j) + cell_size * static_cast<double>(idx_cell);
+    }
+    x = x.cwiseMax(cell_min).cwiseMin(
+        cell_min + Eigen::Vector3d::Constant(cell_size));
+    result.vertices[idx] = x.cast<float>();
+  }
+
+  // Drop collapsed triangles and duplicates, keeping the first orientation
+  std::vector<std::pair<std::array<uint32_t, 3>, size_t>> keys;
+  keys.reserve(mesh.triangles.size());
+  for (const std::array<uint32_t, 3>& f : mesh.triangles) {
+    const std::array<uint32_t, 3> g = {clusters[f[0]], clusters[f[1]],
+                                       clusters[f[2]]};
+    if (g[0] == g[1] || g[1] == g[2] || g[2] == g[0]) continue;
+    std::array<uint32_t, 3> key = g;
+    std::sort(key.begin(), key.end());
+    keys.emplace_back(key, keys.size());
+    result.triangles.push_back(g);
+  }
+  std::sort(keys.begin(), keys.end());
+  std::vector<bool> is_duplicate(result.triangles.size(), false);
+  for (size_t i = 1; i < keys.size(); i++) {
+    if (keys[i].first == keys[i - 1].first) is_duplicate[keys[i].second] = true;
+  }
+
+  // Compact the referenced vertices
+  TriangleMesh compact;
+  std::vector<uint32_t> idx_compact(num_clusters, UINT32_MAX);
+  for (size_t i = 0; i < result.triangles.size(); i++) {
+    if (is_duplicate[i]) continue;
+    std::array<uint32_t, 3> f = result.triangles[i];
+    for (uint32_t& idx : f) {
+      if (idx_compact[idx] == UINT32_MAX) {
+        idx_compact[idx] = static_cast<uint32_t>(compact.vertices.size());
+        compact.vertices.push_back(result.vertices[idx]);
+      }
+      idx = idx_compact[idx];
+    }
+    compact.triangles.push_back(f);
+  }
+  return compact;
+}
+
+}  // namespace internal
+
+/**
+ * Whether a Wavefront OBJ file references a material library.
+ */
+inline bool ObjHasMaterials(const std::string& data) {
+  const char* p = data.c_str();
+  const char* end = p + data.size();
+  while (p < end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) eol = end;
+    while (p < eol && (*p == ' ' || *p == '\t')) p++;
+    if (eol - p > 6 && std::memcmp(p, "mtllib", 6) == 0) return true;
+    p = eol + 1;
+  }
+  return false;
+}
+
+/**
+ * Parses the vertices and faces of a Wavefront OBJ file. Polygons are
+ * triangulated as fans.
+ */
+inline TriangleMesh ParseObj(const std::string& data) {
+  TriangleMesh mesh;
+  std::vector<uint32_t> face;
+  const char* p = data.c_str();
+  const char* end = p + data.size();
+  while (p < end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) eol = end;
+    while (p < eol && (*p == ' ' || *p == '\t')) p++;
+
+    if (eol - p > 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+      Eigen::Vector3f v;
+      char* next = const_cast<char*>(p + 1);
+      for (size_t i = 0; i < 3; i++) v(i) = std::strtof(next, &next);
+      if (next > eol) throw std::runtime_error("ParseObj(): invalid vertex.");
+      mesh.vertices.push_back(v);
+    } else if (eol - p > 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+      face.clear();
+      const char* q = p + 1;
+      while (true) {
+        while (q < eol && (*q == ' ' || *q == '\t')) q++;
+        if (q >= eol || *q == '\r') break;
+
+        // Vertex index of v, v/vt, v//vn or v/vt/vn
+        char* next;
+        const long idx = std::strtol(q, &next, 10);
+        const long num_vertices = static_cast<long>(mesh.vertices.size());
+        const long idx_vertex = idx < 0 ? num_vertices + idx : idx - 1;
+        if (next == q || idx_vertex < 0 || idx_vertex >= num_vertices) {
+          throw std::runtime_error("ParseObj(): invalid face.");
+        }
+        face.push_back(static_cast<uint32_t>(idx_vertex));
+        q = next;
+        while (q < eol && *q != ' ' && *q != '\t' && *q != '\r') q++;
+      }
+      for (size_t i = 2; i < face.size(); i++) {
+        internal::AddTriangle(face[0], face[i - 1], face[i], &mesh);
+      }
+    }
+    p = eol + 1;
+  }
+  return mesh;
+}
+
+/**
+ * Parses a binary or ascii STL file and welds identical vertices.
+ */
+inline TriangleMesh ParseStl(const std::string& data) {
+  TriangleMesh mesh;
+  internal::VertexWelder welder(&mesh);
+
+  // Some binary files also start with "solid", so check the size first
+  uint32_t num_triangles = 0;
+  if (data.size() >= 84) std::memcpy(&num_triangles, &data[80], 4);
+  if (data.size() >= 84 && data.size() == 84 + 50 * size_t{num_triangles}) {
+    mesh.triangles.reserve(num_triangles);
+    for (size_t i = 0; i < num_triangles; i++) {
+      const char* f = &data[84 + 50 * i + 12];
+      std::array<uint32_t, 3> idx;
+      for (size_t j = 0; j < 3; j++) {
+        Eigen::Vector3f v;
+        std::memcpy(v.data(), f + 12 * j, 12);
+        idx[j] = welder.Add(v);
+      }
+      internal::AddTriangle(idx[0], idx[1], idx[2], &mesh);
+    }
+    return mesh;
+  }
+
+  if (data.compare(0, 5, "solid") != 0) {
+    throw std::runtime_error("ParseStl(): invalid STL file.");
+  }
+  std::array<uint32_t, 3> idx;
+  size_t num_vertices = 0;
+  for (size_t pos = data.find("vertex"); pos != std::string::npos;
+       pos = data.find("vertex", pos)) {
+    char* next = const_cast<char*>(&data[pos + 6]);
+    Eigen::Vector3f v;
+    for (size_t i = 0; i < 3; i++) v(i) = std::strtof(next, &next);
+    idx[num_vertices++ % 3] = welder.Add(v);
+    if (num_vertices % 3 == 0) {
+      internal::AddTriangle(idx[0], idx[1], idx[2], &mesh);
+    }
+    pos = next - data.c_str();
+  }
+  return mesh;
+}
+
+/**
+ * Loads an OBJ or STL mesh.
+ */
+inline TriangleMesh LoadMesh(const std::filesystem::path& path) {
+  const std::string ext = internal::ToLower(path.extension().string());
+  if (ext == ".obj") return ParseObj(internal::ReadFile(path));
+  if (ext == ".stl") return ParseStl(internal::ReadFile(path));
+  throw std::runtime_error("LoadMesh(): unsupported mesh " + path.string() +
+                           ".");
+}
+
+/**
+ * Decimates a mesh to at most max_triangles triangles.
+ *
+ * Vertices are clustered on the finest uniform grid that meets the budget,
+ * and each cluster is placed at the minimizer of the quadric error of its
+ * triangles, which preserves sharp features better than the cluster mean.
+ */
+inline TriangleMesh DecimateMesh(const TriangleMesh& mesh,
+                                 size_t max_triangles) {
+  if (mesh.triangles.size() <= max_triangles || mesh.vertices.empty()) {
+    return mesh;
+  }
+
+  Eigen::Vector3f min = mesh.vertices[0];
+  Eigen::Vector3f max = mesh.vertices[0];
+  for (const Eigen::Vector3f& v : mesh.vertices) {
+    min = min.cwiseMin(v);
+    max = max.cwiseMax(v);
+  }
+  const float extent = (max - min).maxCoeff();
+  if (extent <= 0.f) return TriangleMesh();
+
+  // Binary search for the finest grid resolution within the budget
+  std::vector<uint64_t> cells;
+  auto CellSize = [extent](uint32_t resolution) {
+    // Pad so the maximum corner stays inside the last cell
+    return 1.0001f * extent / static_cast<float>(resolution);
+  };
+  uint32_t resolution_min = 1;
+  uint32_t resolution_max = 1 << 20;
+  while (resolution_max - resolution_min > 1) {
+    const uint32_t resolution = resolution_min +
+                                (resolution_max - resolution_min) / 2;
+    internal::AssignCells(mesh, min, CellSize(resolution), &cells);
+    if (internal::CountClusteredTriangles(mesh, cells) <= max_triangles) {
+      resolution_min = resolution;
+    } else {
+      resolution_max = resolution;
+    }
+  }
+
+  internal::AssignCells(mesh, min, CellSize(resolution_min), &cells);
+  return internal::ClusterVertices(mesh, min, CellSize(resolution_min), cells);
+}
+
+/**
+ * Encodes one level of detail in the compact mesh format.
+ */
+inline std::string EncodeMesh(const TriangleMesh& mesh, size_t lod,
+                              size_t num_lods, uint64_t hash) {
+  Eigen::Vector3f min = Eigen::Vector3f::Zero();
+  Eigen::Vector3f max = Eigen::Vector3f::Zero();
+  if (!mesh.vertices.empty()) min = max = mesh.vertices[0];
+  for (const Eigen::Vector3f& v : mesh.vertices) {
+    min = min.cwiseMin(v);
+    max = max.cwiseMax(v);
+  }
+
+  const uint32_t num_vertices = static_cast<uint32_t>(mesh.vertices.size());
+  const uint32_t num_triangles = static_cast<uint32_t>(mesh.triangles.size());
+  const uint8_t index_size = num_vertices <= UINT16_MAX ? 2 : 4;
+  const size_t num_bytes_positions = (6 * size_t{num_vertices} + 3) & ~3;
+  std::string buffer(kMeshHeaderSize + num_bytes_positions +
+                         3 * size_t{index_size} * num_triangles,
+                     '\0');
+
+  char* data = &buffer[0];
+  std::memcpy(data, kMeshMagic, sizeof(kMeshMagic));
+  data[4] = static_cast<char>(kMeshVersion);
+  data[5] = static_cast<char>(lod);
+  data[6] = static_cast<char>(num_lods);
+  data[7] = static_cast<char>(index_size);
+  std::memcpy(data + 8, &num_vertices, sizeof(num_vertices));
+  std::memcpy(data + 12, &num_triangles, sizeof(num_triangles));
+  std::memcpy(data + 16, min.data(), 3 * sizeof(float));
+  std::memcpy(data + 28, max.data(), 3 * sizeof(float));
+  std::memcpy(data + 40, &hash, sizeof(hash));
+
+  // Quantize positions to 16 bits over the bounding box
+  const Eigen::Array3f extent = (max - min).array();
+  const Eigen::Array3f scale =
+      (extent > 0.f).select(UINT16_MAX / extent, Eigen::Array3f::Zero());
+  uint16_t* positions = reinterpret_cast<uint16_t*>(data + kMeshHeaderSize);
+  for (size_t i = 0; i < num_vertices; i++) {
+    const Eigen::Array3f q = (mesh.vertices[i] - min).array() * scale;
+    for (size_t j = 0; j < 3; j++) {
+      positions[3 * i + j] = static_cast<uint16_t>(
+          std::min<long>(std::lround(q(j)), UINT16_MAX));
+    }
+  }
+
+  char* indices = data + kMeshHeaderSize + num_bytes_positions;
+  for (size_t i = 0; i < num_triangles; i++) {
+    for (size_t j = 0; j < 3; j++) {
+      const uint32_t idx = mesh.triangles[i][j];
+      if (index_size == 2) {
+        const uint16_t idx16 = static_cast<uint16_t>(idx);
+        std::memcpy(indices + 2 * (3 * i + j), &idx16, 2);
+      } else {
+        std::memcpy(indices + 4 * (3 * i + j), &idx, 4);
+      }
+    }
+  }
+  return buffer;
+}
+
+/**
+ * Path of a level of detail in the cache, e.g. "link0.obj.lod0.rgm".
+ */
+inline std::filesystem::path MeshCachePath(
+    const std::filesystem::path& path_cache, size_t lod) {
+  return path_cache.string() + ".lod" + std::to_string(lod) + ".rgm";
+}
+
+/**
+ * Decimates and quantizes a mesh into levels of detail.
+ *
+ * Writes `<path_cache>.lod<k>.rgm` for k = 0 (coarsest) to num_lods - 1
+ * (finest, at most options.max_triangles). Each file stores a hash of the
+ * source mesh contents and options, so unchanged meshes are skipped.
+ *
+ * @param path_mesh OBJ or STL mesh.
+ * @param path_cache Cache path prefix, e.g. "cache/meshes/link0.obj".
+ * @return Whether the cache was written, or false if it was up to date.
+ */
+inline bool PreprocessMesh(const std::filesystem::path& path_mesh,
+                           const std::filesystem::path& path_cache,
+                           const MeshPreprocessOptions& options = {}) {
+  const std::string data = internal::ReadFile(path_mesh);
+  const std::array<double, 4> params = {
+      static_cast<double>(options.max_triangles),
+      static_cast<double>(options.num_lods), options.lod_ratio,
+      static_cast<double>(options.min_triangles)};
+  uint64_t hash = internal::HashFnv1a(data.data(), data.size());
+  hash = internal::HashFnv1a(params.data(), sizeof(params), hash);
+  hash = internal::HashFnv1a(&kMeshVersion, sizeof(kMeshVersion), hash);
+
+  // Compare the hash in the header of the coarsest level
+  {
+    std::ifstream file(MeshCachePath(path_cache, 0), std::ios::binary);
+    char header[kMeshHeaderSize];
+    uint64_t hash_cache = 0;
+    if (file.read(header, kMeshHeaderSize)) {
+      std::memcpy(&hash_cache, header + 40, sizeof(hash_cache));
+    }
+    if (file && hash_cache == hash) return false;
+  }
+
+  const std::string ext = internal::ToLower(path_mesh.extension().string());
+  const TriangleMesh mesh = ext == ".stl" ? ParseStl(data) : ParseObj(data);
+
+  // Generate levels from finest to coarsest
+  std::vector<TriangleMesh> lods;
+  double target = static_cast<double>(options.max_triangles);
+  for (size_t i = 0; i < std::max<size_t>(options.num_lods, 1); i++) {
+    if (i > 0 && (target < options.min_triangles ||
+                  lods.back().triangles.size() <= options.min_triangles)) {
+      break;
+    }
+    TriangleMesh lod = DecimateMesh(mesh, static_cast<size_t>(target));
+    if (i > 0 && lod.triangles.size() >= lods.back().triangles.size()) break;
+    lods.push_back(std::move(lod));
+    target *= options.lod_ratio;
+  }
+
+  // Write the coarsest level last so an interrupted run is not cached
+  std::filesystem::create_directories(path_cache.parent_path());
+  for (size_t lod = lods.size(); lod-- > 0;) {
+    const std::filesystem::path path = MeshCachePath(path_cache, lod);
+    const std::string buffer =
+        EncodeMesh(lods[lods.size() - 1 - lod], lod, lods.size(), hash);
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(buffer.data(), buffer.size())) {
+      throw std::runtime_error("PreprocessMesh(): could not write " +
+                               path.string() + ".");
+    }
+  }
+  return true;
+}
+
+/**
+ * Preprocesses every OBJ and STL mesh under a resource directory into a cache
+ * directory with the same layout, and lists the cached meshes of each
+ * directory in kMeshIndexFilename.
+ *
+ * Register the cache directory with RegisterResourcePath() alongside the
+ * resource directory, and the viewer loads the coarsest level of each mesh
+ * first, refining it as the finer levels arrive. Meshes without a cache, and
+ * other formats such as DAE, are loaded from the original files. OBJ meshes
+ * with a material library are not cached, since the compact format has no
+ * materials.
+ *
+ * @return Number of meshes written. Up to date meshes are skipped.
+ */
+inline size_t PreprocessResources(const std::filesystem::path& dir_resources,
+                                  const std::filesystem::path& dir_cache,
+                                  const MeshPreprocessOptions& options = {}) {
+  // Cache directory -> file names of its cached meshes
+  std::map<std::filesystem::path, std::vector<std::string>> indices;
+
+  size_t num_written = 0;
+  for (const std::filesystem::directory_entry& entry :
+       std::filesystem::recursive_directory_iterator(dir_resources)) {
+    if (!entry.is_regular_file()) continue;
+    const std::string ext =
+        internal::ToLower(entry.path().extension().string());
+    if (ext != ".obj" && ext != ".stl") continue;
+
+    const std::filesystem::path path_cache =
+        dir_cache / std::filesystem::relative(entry.path(), dir_resources);
+    std::vector<std::string>& index = indices[path_cache.parent_path()];
+    if (ext == ".obj" && ObjHasMaterials(internal::ReadFile(entry.path()))) {
+      // Remove the levels cached before the mesh had materials
+      size_t lod = 0;
+      while (std::filesystem::remove(MeshCachePath(path_cache, lod))) lod++;
+      continue;
+    }
+
+    num_written += PreprocessMesh(entry.path(), path_cache, options);
+    index.push_back(path_cache.filename().string());
+  }
+
+  for (auto& [dir, index] : indices) {
+    const std::filesystem::path path_index = dir / kMeshIndexFilename;
+    if (index.empty()) {
+      std::filesystem::remove(path_index);
+      continue;
+    }
+
+    std::sort(index.begin(), index.end());
+    std::ofstream file(path_index);
+    for (const std::string& filename : index) file << filename << "\n";
+    if (!file) {
+      throw std::runtime_error("PreprocessResources(): could not write " +
+                               path_index.string() + ".");
+    }
+  }
+  return num_written;
+}
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_MESH_H_
@@ -0,0 +1,261 @@
+/**
+ * model_cache.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_MODEL_CACHE_H_
+#define REDIS_GL_MODEL_CACHE_H_
+
+#include "redis_gl/robot.h"
+
+// std
+#include <cstdint>        // uint64_t
+#include <cstdio>         // std::snprintf
+#include <string>         // std::string
+#include <unordered_map>  // std::unordered_map
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Computes the 64-bit FNV-1a hash of a string as 16 hex characters.
+ */
+inline std::string ContentHash(const std::string& data) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  char str[17];
+  std::snprintf(str, sizeof(str), "%016llx",
+                static_cast<unsigned long long>(hash));
+  return std::string(str, 16);
+}
+
+/**
+ * Content-addressed cache for robot and object descriptions.
+ *
+ * The heavy part of a model (the articulated body without its name and base
+ * pose, or the graphics of an object) is stored once per namespace under
+ * `<namespace>::description::<hash>`. The model key itself only holds a small
+ * reference to the description, so several robots of the same type share one
+ * description, and re-registering an unchanged model sends nothing to Redis.
+ *
+ * Without a version, every registration serializes and hashes the model to
+ * detect changes. With a caller-maintained version, re-registering an
+ * unchanged model is a single lookup and only a new version is serialized.
+ *
+ * A description is sent along with every model reference that points to it,
+ * so it reappears whenever a model is re-uploaded after Redis lost it. The
+ * cache forgets its models whenever model keys are unregistered in this
+ * process (e.g. by ClearModelKeys()). Clear() must be called by hand if
+ * another process clears the namespace.
+ *
+ * Model reference formats:
+ *
+ *     robot:  {"articulated_body_hash": <hash>, "name": <name>,
+ *              "T_base_to_world": <pose>, "key_q": ..., ...}
+ *     object: {"graphics_hash": <hash>, "key_pos": ..., ...}
+ *
+ * Example:
+ *
+ *     ModelCache model_cache;
+ *     model_cache.RegisterRobot(redis, model_keys, robot, version_robot);
+ *     model_cache.RegisterObject(redis, model_keys, object);
+ *     redis.commit();
+ */
+class ModelCache {
+ public:
+  /**
+   * Registers a robot through the cache.
+   *
+   * Descriptions are uploaded with SET NX alongside the model reference, so a
+   * description already stored by another process is not overwritten and no
+   * reply is awaited.
+   *
+   * @return True if any key was uploaded.
+   */
+  bool RegisterRobot(ctrl_utils::RedisClient& redis,
+                     const ModelKeys& model_keys, const RobotModel& robot,
+                     bool commit = false) {
+    SyncGeneration();
+    const spatial_dyn::ArticulatedBody& ab = *robot.articulated_body;
+
+    // Separate the instance-specific fields from the shared description
+    nlohmann::json description = ab;
+    nlohmann::json model;
+    model["name"] = description["name"];
+    model["T_base_to_world"] = description["T_base_to_world"];
+    description.erase("name");
+    description.erase("T_base_to_world");
+
+    const std::string str_description = description.dump();
+    const std::string hash_description = ContentHash(str_description);
+    model["articulated_body_hash"] = hash_description;
+    model["key_q"] = robot.key_q;
+    model["key_pos"] = robot.key_pos;
+    model["key_ori"] = robot.key_ori;
+    if (!robot.key_link_transforms.empty()) {
+      model["key_link_transforms"] = robot.key_link_transforms;
+    }
+    const bool uploaded = UploadModel(redis, model_keys,
+                                      RobotKey(model_keys, ab.name), model,
+                                      hash_description, str_description);
+    if (commit) redis.commit();
+    return uploaded;
+  }
+
+  /**
+   * Registers a robot through the cache, skipping serialization while its
+   * version is unchanged.
+   *
+   * @param version Caller-maintained version that changes whenever the robot
+   *                or its keys change.
+   * @return True if any key was uploaded.
+   */
+  bool RegisterRobot(ctrl_utils::RedisClient& redis,
+                     const ModelKeys& model_keys, const RobotModel& robot,
+                     uint64_t version, bool commit = false) {
+    SyncGeneration();
+    const RobotKey key(model_keys, robot.articulated_body->name);
+    if (IsCurrent(key, version)) return false;
+
+    const bool uploaded = RegisterRobot(redis, model_keys, robot, commit);
+    SetVersion(key, version);
+    return uploaded;
+  }
+
+  /**
+   * Registers an object through the cache.
+   *
+   * @return True if any key was uploaded.
+   */
+  bool RegisterObject(ctrl_utils::RedisClient& redis,
+                      const ModelKeys& model_keys, const ObjectModel& object,
+                      const std::string& key_matrix = "",
+                      float axis_size = 0.01, bool commit = false) {
+    SyncGeneration();
+    const nlohmann::json graphics = object.graphics;
+    const std::string str_description = graphics.dump();
+
+    nlohmann::json model;
+    const std::string hash_description = ContentHash(str_description);
+    model["graphics_hash"] = hash_description;
+    model["key_pos"] = object.key_pos;
+    model["key_ori"] = object.key_ori;
+    model["key_scale"] = object.key_scale;
+    model["key_matrix"] = key_matrix;
+    model["axis_size"] = axis_size;
+    const bool uploaded = UploadModel(redis, model_keys,
+                                      ObjectKey(model_keys, object.name), model,
+                                      hash_description, str_description);
+    if (commit) redis.commit();
+    return uploaded;
+  }
+
+  /**
+   * Registers an object through the cache, skipping serialization while its
+   * version is unchanged.
+   *
+   * @param version Caller-maintained version that changes whenever the
+   *                object, its keys, key_matrix, or axis_size change.
+   * @return True if any key was uploaded.
+   */
+  bool RegisterObject(ctrl_utils::RedisClient& redis,
+                      const ModelKeys& model_keys, const ObjectModel& object,
+                      uint64_t version, const std::string& key_matrix = "",
+                      float axis_size = 0.01, bool commit = false) {
+    SyncGeneration();
+    const ObjectKey key(model_keys, object.name);
+    if (IsCurrent(key, version)) return false;
+
+    const bool uploaded = RegisterObject(redis, model_keys, object, key_matrix,
+                                         axis_size, commit);
+    SetVersion(key, version);
+    return uploaded;
+  }
+
+  /**
+   * Forgets all cached models, e.g. after another process has cleared the
+   * namespace.
+   */
+  void Clear() { models_.clear(); }
+
+ private:
+  struct CachedModel {
+    // Hash of the last uploaded reference
+    std::string hash;
+
+    // Caller-supplied version of the reference, if any
+    uint64_t version = 0;
+    bool has_version = false;
+  };
+
+  /**
+   * Forgets all models if model keys were unregistered since the last call.
+   */
+  void SyncGeneration() {
+    const uint64_t generation = ModelKeysGeneration();
+    if (generation == generation_) return;
+    Clear();
+    generation_ = generation;
+  }
+
+  bool IsCurrent(const std::string& key, uint64_t version) const {
+    auto it = models_.find(key);
+    return it != models_.end() && it->second.has_version &&
+           it->second.version == version;
+  }
+
+  void SetVersion(const std::string& key, uint64_t version) {
+    CachedModel& cached = models_[key];
+    cached.version = version;
+    cached.has_version = true;
+  }
+
+  /**
+   * Uploads a model reference, preceded by its description, unless the
+   * reference is unchanged.
+   */
+  bool UploadModel(ctrl_utils::RedisClient& redis, const ModelKeys& model_keys,
+                   const std::string& key, const nlohmann::json& model,
+                   const std::string& hash_description,
+                   const std::string& description) {
+    const std::string str_model = model.dump();
+    const std::string hash = ContentHash(str_model);
+
+    CachedModel& cached = models_[key];
+    cached.has_version = false;
+    if (cached.hash == hash) return false;
+    cached.hash = hash;
+
+    // Resend the description in case Redis lost it, but keep it if another
+    // process already stored it
+    const std::string key_description =
+        model_keys.key_descriptions_prefix + hash_description;
+    redis.send({"SET", key_description, description, "NX"},
+               [](cpp_redis::reply&) {});
+    AddToRegistry(redis, model_keys, key_description);
+
+    redis.send({"SET", key, str_model}, [](cpp_redis::reply&) {});
+    AddToRegistry(redis, model_keys, key);
+    return true;
+  }
+
+  // Last registered reference for each model key
+  std::unordered_map<std::string, CachedModel> models_;
+
+  // Value of ModelKeysGeneration() the cache was filled with
+  uint64_t generation_ = ModelKeysGeneration();
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_MODEL_CACHE_H_
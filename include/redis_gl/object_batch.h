@@ -0,0 +1,258 @@
+/**
+ * object_batch.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_OBJECT_BATCH_H_
+#define REDIS_GL_OBJECT_BATCH_H_
+
+#include "redis_gl/redis_gl.h"
+
+// std
+#include <cstdint>    // uint8_t, uint32_t
+#include <cstring>    // std::memcpy, std::memset
+#include <sstream>    // std::stringstream
+#include <stdexcept>  // std::invalid_argument, std::out_of_range
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+// external
+#include <spatial_dyn/parsers/json.h>
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Packed instance format published by ObjectBatchPublisher.
+ *
+ * The buffer starts with a 16-byte little-endian header:
+ *
+ *     0  uint8[4] magic "\xffRGI"
+ *     4  uint8    version
+ *     5  uint8    flags (kObjectBatchScales | kObjectBatchColors)
+ *     6  uint16   reserved
+ *     8  uint32   number of instances N
+ *     12 uint32   reserved
+ *
+ * followed by N float32 poses (x y z qx qy qz qw), then N float32 xyz scales
+ * if kObjectBatchScales is set, then N uint8 rgb colors if kObjectBatchColors
+ * is set.
+ */
+constexpr char kObjectBatchMagic[4] = {'\xff', 'R', 'G', 'I'};
+constexpr uint8_t kObjectBatchVersion = 1;
+constexpr size_t kObjectBatchHeaderSize = 16;
+constexpr uint8_t kObjectBatchScales = 1 << 0;
+constexpr uint8_t kObjectBatchColors = 1 << 1;
+
+/**
+ * Many instances of the same graphics (e.g. grasp candidates or contact
+ * points) whose poses, scales and colors are published together in one key.
+ *
+ * The viewer draws each batch with one instanced mesh per graphics primitive,
+ * so the number of instances does not change the number of model keys, update
+ * callbacks or draw calls.
+ */
+struct ObjectBatchModel {
+  std::string name;
+  spatial_dyn::Graphics graphics;
+
+  // Packed instances published by ObjectBatchPublisher.
+  std::string key_instances;
+};
+
+inline void from_json(const nlohmann::json& json, ObjectBatchModel& batch) {
+  batch.name = json.at("name").get<std::string>();
+  batch.graphics = json.at("graphics").get<spatial_dyn::Graphics>();
+  batch.key_instances = json.at("key_instances").get<std::string>();
+}
+
+inline void to_json(nlohmann::json& json, const ObjectBatchModel& batch) {
+  json["name"] = batch.name;
+  json["graphics"] = batch.graphics;
+  json["key_instances"] = batch.key_instances;
+}
+
+inline std::stringstream& operator<<(std::stringstream& ss,
+                                     const ObjectBatchModel& batch) {
+  ss << nlohmann::json(batch).dump();
+  return ss;
+}
+
+inline std::stringstream& operator>>(std::stringstream& ss,
+                                     ObjectBatchModel& batch) {
+  nlohmann::json json = nlohmann::json::parse(ss.str());
+  ss.seekg(ss.str().size());
+  batch = json.get<ObjectBatchModel>();
+  return ss;
+}
+
+inline void RegisterObjectBatch(ctrl_utils::RedisClient& redis,
+                                const ModelKeys& model_keys,
+                                const ObjectBatchModel& batch,
+                                bool commit = false) {
+  RegisterModel(redis, model_keys, ObjectBatchKey(model_keys, batch.name),
+                nlohmann::json(batch), commit);
+}
+
+inline void UnregisterObjectBatch(ctrl_utils::RedisClient& redis,
+                                  const ModelKeys& model_keys,
+                                  const std::string& name,
+                                  bool commit = false) {
+  UnregisterModel(redis, model_keys, ObjectBatchKey(model_keys, name), commit);
+}
+
+/**
+ * Packs the instances of an object batch and publishes them to
+ * `ObjectBatchModel::key_instances` as a single binary value.
+ *
+ * Example:
+ *
+ *     ObjectBatchPublisher publisher(grasps.size(), false, true);
+ *     for (size_t i = 0; i < grasps.size(); i++) {
+ *       publisher.SetPose(i, grasps[i].pos, grasps[i].quat);
+ *       publisher.SetColor(i, Eigen::Vector3d(1. - grasps[i].score,
+ *                                             grasps[i].score, 0.));
+ *     }
+ *     publisher.Publish(redis, batch);
+ *     redis.commit();
+ */
+class ObjectBatchPublisher {
+ public:
+  /**
+   * @param num_instances Number of instances.
+   * @param scales Publish a scale per instance.
+   * @param colors Publish a color per instance, replacing the material color.
+   */
+  explicit ObjectBatchPublisher(size_t num_instances = 0, bool scales = false,
+                                bool colors = false)
+      : flags_((scales ? kObjectBatchScales : 0) |
+               (colors ? kObjectBatchColors : 0)) {
+    Resize(num_instances);
+  }
+
+  /**
+   * Resizes the batch. New instances have the identity pose, unit scale and
+   * white color.
+   */
+  void Resize(size_t num_instances) {
+    poses_.resize(7 * num_instances, 0.f);
+    for (size_t i = num_instances_; i < num_instances; i++) {
+      poses_[7 * i + 6] = 1.f;
+    }
+    if (flags_ & kObjectBatchScales) scales_.resize(3 * num_instances, 1.f);
+    if (flags_ & kObjectBatchColors) colors_.resize(3 * num_instances, 255);
+    num_instances_ = num_instances;
+  }
+
+  void SetPose(size_t idx, const Eigen::Vector3d& pos,
+               const Eigen::Quaterniond& quat) {
+    CheckIndex("SetPose", idx);
+    float* pose = &poses_[7 * idx];
+    Eigen::Map<Eigen::Vector3f> map_pos(pose);
+    Eigen::Map<Eigen::Vector4f> map_quat(pose + 3);
+    map_pos = pos.cast<float>();
+    map_quat = quat.coeffs().cast<float>();
+  }
+
+  void SetPose(size_t idx, const Eigen::Isometry3d& T) {
+    SetPose(idx, T.translation(), Eigen::Quaterniond(T.linear()));
+  }
+
+  /**
+   * Sets the scale of an instance. Requires `scales` in the constructor.
+   *
+   * @throws std::invalid_argument if the batch has no scales.
+   */
+  void SetScale(size_t idx, const Eigen::Vector3d& scale) {
+    if (!(flags_ & kObjectBatchScales)) {
+      throw std::invalid_argument(
+          "ObjectBatchPublisher::SetScale(): constructed without scales.");
+    }
+    CheckIndex("SetScale", idx);
+    Eigen::Map<Eigen::Vector3f> map_scale(&scales_[3 * idx]);
+    map_scale = scale.cast<float>();
+  }
+
+  /**
+   * Sets the rgb color of an instance with components in [0, 1]. Requires
+   * `colors` in the constructor.
+   *
+   * @throws std::invalid_argument if the batch has no colors.
+   */
+  void SetColor(size_t idx, const Eigen::Vector3d& rgb) {
+    if (!(flags_ & kObjectBatchColors)) {
+      throw std::invalid_argument(
+          "ObjectBatchPublisher::SetColor(): constructed without colors.");
+    }
+    CheckIndex("SetColor", idx);
+    for (size_t i = 0; i < 3; i++) {
+      const double c = rgb(i) < 0. ? 0. : rgb(i) > 1. ? 1. : rgb(i);
+      colors_[3 * idx + i] = static_cast<uint8_t>(255. * c + 0.5);
+    }
+  }
+
+  /**
+   * Packs the instances into the reusable buffer.
+   */
+  const std::string& Pack() {
+    const size_t num_bytes_poses = sizeof(float) * poses_.size();
+    const size_t num_bytes_scales = sizeof(float) * scales_.size();
+    buffer_.resize(kObjectBatchHeaderSize + num_bytes_poses +
+                   num_bytes_scales + colors_.size());
+
+    char* data = &buffer_[0];
+    std::memset(data, 0, kObjectBatchHeaderSize);
+    std::memcpy(data, kObjectBatchMagic, sizeof(kObjectBatchMagic));
+    data[4] = static_cast<char>(kObjectBatchVersion);
+    data[5] = static_cast<char>(flags_);
+    const uint32_t num_instances = static_cast<uint32_t>(num_instances_);
+    std::memcpy(data + 8, &num_instances, sizeof(num_instances));
+
+    data += kObjectBatchHeaderSize;
+    std::memcpy(data, poses_.data(), num_bytes_poses);
+    data += num_bytes_poses;
+    if (!scales_.empty()) std::memcpy(data, scales_.data(), num_bytes_scales);
+    data += num_bytes_scales;
+    if (!colors_.empty()) std::memcpy(data, colors_.data(), colors_.size());
+    return buffer_;
+  }
+
+  /**
+   * Packs and sets the instances of the batch.
+   */
+  void Publish(ctrl_utils::RedisClient& redis, const ObjectBatchModel& batch,
+               bool commit = false) {
+    redis.send({"SET", batch.key_instances, Pack()},
+               [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+  }
+
+  size_t size() const { return num_instances_; }
+
+ private:
+  void CheckIndex(const char* function, size_t idx) const {
+    if (idx < num_instances_) return;
+    throw std::out_of_range("ObjectBatchPublisher::" + std::string(function) +
+                            "(): index " + std::to_string(idx) +
+                            " is out of range for " +
+                            std::to_string(num_instances_) + " instances.");
+  }
+
+  uint8_t flags_;
+  size_t num_instances_ = 0;
+  std::vector<float> poses_;
+  std::vector<float> scales_;
+  std::vector<uint8_t> colors_;
+  std::string buffer_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_OBJECT_BATCH_H_
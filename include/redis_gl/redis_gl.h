@@ -11,11 +11,19 @@
 #define REDIS_GL_REDIS_GL_H_
 
 // std
-#include <array>    // std::array
-#include <set>      // std::set
-#include <sstream>  // std::stringstream
-#include <string>   // std::string
-#include <utility>  // std::move
+#include <algorithm>      // std::copy_n, std::min
+#include <array>          // std::array
+#include <atomic>         // std::atomic
+#include <cstdint>        // uint8_t, uint64_t
+#include <future>         // std::future, std::promise
+#include <memory>         // std::make_shared
+#include <set>            // std::set
+#include <sstream>        // std::stringstream
+#include <string>         // std::string
+#include <string_view>    // std::string_view
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move
+#include <vector>         // std::vector
 
 // external
 #include <ctrl_utils/json.h>
@@ -25,39 +33,137 @@ namespace redis_gl {
 
 namespace webapp {
 
-const std::string KEY_PREFIX = "webapp::";
-const std::string KEY_RESOURCES_PREFIX =
+// Inline so that each constant is constructed once per program rather than
+// once per translation unit.
+inline const std::string KEY_PREFIX = "webapp::";
+inline const std::string KEY_RESOURCES_PREFIX =
     KEY_PREFIX + "resources::";  // webapp::resources::
 
 }  // namespace webapp
 
 namespace simulator {
 
-const std::string kName = "simulator";
-const std::string KEY_PREFIX =
-    webapp::KEY_PREFIX + kName + "::";             // webapp::simulator::
-const std::string KEY_ARGS = KEY_PREFIX + "args";  // webapp::simulator::args
-const std::string KEY_INTERACTION =
+inline const std::string kName = "simulator";
+inline const std::string KEY_PREFIX =
+    webapp::KEY_PREFIX + kName + "::";  // webapp::simulator::
+inline const std::string KEY_ARGS =
+    KEY_PREFIX + "args";  // webapp::simulator::args
+inline const std::string KEY_INTERACTION =
     KEY_PREFIX + "interaction";  // webapp::simulator::interaction
-const std::string KEY_RESOURCES =
+inline const std::string KEY_RESOURCES =
     webapp::KEY_RESOURCES_PREFIX + kName;  // webapp::resources::simulator
 
 struct ModelKeys {
+  // Suffixes appended to the namespace.
+  static constexpr std::string_view kRobotsSuffix = "::model::robot::";
+  static constexpr std::string_view kObjectsSuffix = "::model::object::";
+  static constexpr std::string_view kTrajectoriesSuffix =
+      "::model::trajectory::";
+  static constexpr std::string_view kCamerasSuffix = "::model::camera::";
+  static constexpr std::string_view kObjectBatchesSuffix =
+      "::model::object_batch::";
+  static constexpr std::string_view kDescriptionsSuffix = "::description::";
+  static constexpr std::string_view kFrameSuffix = "::frame";
+  static constexpr std::string_view kRegistrySuffix = "::registry";
+  static constexpr std::string_view kLatencySuffix = "::latency";
+  static constexpr std::string_view kLatencyStampsSuffix =
+      "::latency::stamp::";
+
   ModelKeys() = default;
   ModelKeys(const std::string& key_namespace)
       : key_namespace(key_namespace),
-        key_robots_prefix(key_namespace + "::model::robot::"),
-        key_objects_prefix(key_namespace + "::model::object::"),
-        key_trajectories_prefix(key_namespace + "::model::trajectory::"),
-        key_cameras_prefix(key_namespace + "::model::camera::") {}
+        key_robots_prefix(Concat(key_namespace, kRobotsSuffix)),
+        key_objects_prefix(Concat(key_namespace, kObjectsSuffix)),
+        key_trajectories_prefix(Concat(key_namespace, kTrajectoriesSuffix)),
+        key_cameras_prefix(Concat(key_namespace, kCamerasSuffix)),
+        key_object_batches_prefix(Concat(key_namespace, kObjectBatchesSuffix)),
+        key_descriptions_prefix(Concat(key_namespace, kDescriptionsSuffix)),
+        key_frame(Concat(key_namespace, kFrameSuffix)),
+        key_registry(Concat(key_namespace, kRegistrySuffix)),
+        key_latency(Concat(key_namespace, kLatencySuffix)),
+        key_latency_stamps_prefix(Concat(key_namespace, kLatencyStampsSuffix)) {
+  }
+
+  /**
+   * Concatenates two strings with a single allocation.
+   */
+  static std::string Concat(std::string_view a, std::string_view b) {
+    std::string str;
+    str.reserve(a.size() + b.size());
+    str.append(a);
+    str.append(b);
+    return str;
+  }
 
   std::string key_namespace;
   std::string key_robots_prefix;
   std::string key_objects_prefix;
   std::string key_trajectories_prefix;
   std::string key_cameras_prefix;
+  std::string key_object_batches_prefix;
+  std::string key_descriptions_prefix;
+  std::string key_frame;
+
+  // Set of all model keys registered in this namespace.
+  std::string key_registry;
+
+  // Latency report written by the server (see latency.h).
+  std::string key_latency;
+
+  // Per-family latency stamps written by the controller.
+  std::string key_latency_stamps_prefix;
+};
+
+enum class ModelType { kRobot, kObject, kTrajectory, kCamera, kObjectBatch };
+
+/**
+ * Typed handle of a model key, resolved once from the namespace and name.
+ *
+ * All Register* and Unregister* functions resolve their keys through this
+ * handle. Code that refers to the same model repeatedly can keep the handle
+ * and pass it to RegisterModel() and UnregisterModel() directly.
+ *
+ * Example:
+ *
+ *     const RobotKey key_robot(model_keys, ab.name);
+ *     RegisterModel(redis, model_keys, key_robot, nlohmann::json(robot));
+ */
+template <ModelType Type>
+class ModelKey {
+ public:
+  ModelKey(const ModelKeys& model_keys, std::string_view name)
+      : key_(ModelKeys::Concat(Prefix(model_keys), name)) {}
+
+  const std::string& key() const& { return key_; }
+
+  std::string key() && { return std::move(key_); }
+
+  operator const std::string&() const { return key_; }
+
+  static const std::string& Prefix(const ModelKeys& model_keys) {
+    if constexpr (Type == ModelType::kRobot) {
+      return model_keys.key_robots_prefix;
+    } else if constexpr (Type == ModelType::kObject) {
+      return model_keys.key_objects_prefix;
+    } else if constexpr (Type == ModelType::kTrajectory) {
+      return model_keys.key_trajectories_prefix;
+    } else if constexpr (Type == ModelType::kCamera) {
+      return model_keys.key_cameras_prefix;
+    } else {
+      return model_keys.key_object_batches_prefix;
+    }
+  }
+
+ private:
+  std::string key_;
 };
 
+using RobotKey = ModelKey<ModelType::kRobot>;
+using ObjectKey = ModelKey<ModelType::kObject>;
+using TrajectoryKey = ModelKey<ModelType::kTrajectory>;
+using CameraKey = ModelKey<ModelType::kCamera>;
+using ObjectBatchKey = ModelKey<ModelType::kObjectBatch>;
+
 struct CameraModel {
   std::string name;
   std::string key_pos;
@@ -65,6 +171,12 @@ struct CameraModel {
   std::string key_intrinsic;
   std::string key_depth_image;
   std::string key_color_image;
+
+  // Number of image pyramid levels published by ImagePublisher.
+  size_t num_levels = 1;
+
+  // World-frame point cloud published by PointCloudPublisher (optional).
+  std::string key_point_cloud;
 };
 
 inline void from_json(const nlohmann::json& json, CameraModel& camera) {
@@ -74,6 +186,8 @@ inline void from_json(const nlohmann::json& json, CameraModel& camera) {
   camera.key_intrinsic = json.at("key_intrinsic").get<std::string>();
   camera.key_depth_image = json.at("key_depth_image").get<std::string>();
   camera.key_color_image = json.at("key_color_image").get<std::string>();
+  camera.num_levels = json.value("num_levels", size_t{1});
+  camera.key_point_cloud = json.value("key_point_cloud", std::string());
 }
 
 inline void to_json(nlohmann::json& json, const CameraModel& camera) {
@@ -83,6 +197,8 @@ inline void to_json(nlohmann::json& json, const CameraModel& camera) {
   json["key_intrinsic"] = camera.key_intrinsic;
   json["key_depth_image"] = camera.key_depth_image;
   json["key_color_image"] = camera.key_color_image;
+  json["num_levels"] = camera.num_levels;
+  json["key_point_cloud"] = camera.key_point_cloud;
 }
 
 inline std::stringstream& operator<<(std::stringstream& ss,
@@ -99,6 +215,26 @@ inline std::stringstream& operator>>(std::stringstream& ss,
   return ss;
 }
 
+struct TrajectoryModel {
+  std::string name;
+  std::string key_pos;
+
+  // Simplified samples published by TrajectoryPublisher (optional).
+  std::string key_samples;
+};
+
+inline void from_json(const nlohmann::json& json, TrajectoryModel& trajectory) {
+  trajectory.name = json.at("name").get<std::string>();
+  trajectory.key_pos = json.at("key_pos").get<std::string>();
+  trajectory.key_samples = json.value("key_samples", std::string());
+}
+
+inline void to_json(nlohmann::json& json, const TrajectoryModel& trajectory) {
+  json["name"] = trajectory.name;
+  json["key_pos"] = trajectory.key_pos;
+  json["key_samples"] = trajectory.key_samples;
+}
+
 struct Interaction {
   enum class Key { kUndefined, kAlt, kCtrl, kMeta, kShift };
 
@@ -110,8 +246,116 @@ struct Interaction {
   std::string key_down;
 };
 
+/**
+ * Fixed-capacity string that can be copied and assigned without allocating.
+ *
+ * Strings longer than the capacity are truncated.
+ */
+template <size_t Capacity>
+class FixedString {
+ public:
+  FixedString() = default;
+
+  FixedString(std::string_view str) { assign(str); }
+
+  FixedString& operator=(std::string_view str) {
+    assign(str);
+    return *this;
+  }
+
+  void assign(std::string_view str) {
+    size_ = std::min(str.size(), Capacity);
+    std::copy_n(str.data(), size_, data_.data());
+    data_[size_] = '\0';
+  }
+
+  void clear() { assign(std::string_view()); }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  static constexpr size_t capacity() { return Capacity; }
+
+  const char* c_str() const { return data_.data(); }
+  char operator[](size_t idx) const { return data_[idx]; }
+
+  std::string_view view() const {
+    return std::string_view(data_.data(), size_);
+  }
+  operator std::string_view() const { return view(); }
+
+  bool operator==(std::string_view other) const { return view() == other; }
+  bool operator!=(std::string_view other) const { return view() != other; }
+
+ private:
+  std::array<char, Capacity + 1> data_ = {};
+  size_t size_ = 0;
+};
+
+/**
+ * Allocation-free counterpart of Interaction for real-time control loops.
+ *
+ * Modifier keys are stored as a bitmask and strings with a fixed capacity, so
+ * the struct is trivially copyable and can be shared between threads without
+ * touching the heap.
+ */
+struct RealtimeInteraction {
+  static constexpr size_t kMaxKeyObjectLength = 255;
+  static constexpr size_t kMaxKeyDownLength = 31;
+
+  RealtimeInteraction() = default;
+
+  explicit RealtimeInteraction(const Interaction& interaction)
+      : key_object(interaction.key_object),
+        idx_link(interaction.idx_link),
+        pos_click_in_link(interaction.pos_click_in_link),
+        pos_mouse_in_world(interaction.pos_mouse_in_world),
+        key_down(interaction.key_down) {
+    for (const Interaction::Key key : interaction.modifier_keys) {
+      modifier_keys |= KeyMask(key);
+    }
+  }
+
+  static constexpr uint8_t KeyMask(Interaction::Key key) {
+    return static_cast<uint8_t>(1 << static_cast<int>(key));
+  }
+
+  FixedString<kMaxKeyObjectLength> key_object;
+  int idx_link = 0;
+  Eigen::Vector3d pos_click_in_link = Eigen::Vector3d::Zero();
+  Eigen::Vector3d pos_mouse_in_world = Eigen::Vector3d::Zero();
+  uint8_t modifier_keys = 0;
+  FixedString<kMaxKeyDownLength> key_down;
+};
+
+inline bool HasModifierKey(const Interaction& interaction,
+                           Interaction::Key key) {
+  return interaction.modifier_keys.find(key) !=
+         interaction.modifier_keys.end();
+}
+
+inline bool HasModifierKey(const RealtimeInteraction& interaction,
+                           Interaction::Key key) {
+  return interaction.modifier_keys & RealtimeInteraction::KeyMask(key);
+}
+
+/**
+ * Checks whether the interaction key refers to the model with the given prefix
+ * and name, without building the concatenated key.
+ */
+inline bool IsModelKey(std::string_view key, std::string_view prefix,
+                       std::string_view name) {
+  return key.size() == prefix.size() + name.size() &&
+         key.substr(0, prefix.size()) == prefix &&
+         key.substr(prefix.size()) == name;
+}
+
+/**
+ * The interaction adjustment functions accept either an Interaction or a
+ * RealtimeInteraction. The latter never allocates.
+ */
+template <typename InteractionT>
 inline Eigen::Vector3d ClickPositionAdjustment(
-    const redis_gl::simulator::Interaction& interaction,
+    const InteractionT& interaction,
     const Eigen::Vector3d& pos, const Eigen::Quaterniond& quat,
     double gain = 1e-2) {
   const Eigen::Isometry3d T_object_to_world = Eigen::Translation3d(pos) * quat;
@@ -121,8 +365,9 @@ inline Eigen::Vector3d ClickPositionAdjustment(
   return gain * (interaction.pos_mouse_in_world - pos_click_in_world);
 }
 
+template <typename InteractionT>
 inline Eigen::AngleAxisd ClickOrientationAdjustment(
-    const redis_gl::simulator::Interaction& interaction,
+    const InteractionT& interaction,
     const Eigen::Vector3d& pos, const Eigen::Quaterniond& quat,
     double gain = 1e-1) {
   const Eigen::Isometry3d T_object_to_world = Eigen::Translation3d(pos) * quat;
@@ -138,20 +383,20 @@ inline Eigen::AngleAxisd ClickOrientationAdjustment(
                            r_com_x_m_click.normalized());
 }
 
-inline void ClickAdjustPose(const redis_gl::simulator::Interaction& interaction,
+template <typename InteractionT>
+inline void ClickAdjustPose(const InteractionT& interaction,
                             Eigen::Vector3d* pos, Eigen::Quaterniond* ori,
                             double gain_pos = 1e-2, double gain_ori = 1e-1) {
-  if (interaction.modifier_keys.find(
-          redis_gl::simulator::Interaction::Key::kCtrl) !=
-      interaction.modifier_keys.end()) {
+  if (HasModifierKey(interaction, Interaction::Key::kCtrl)) {
     *ori = ClickOrientationAdjustment(interaction, *pos, *ori, gain_ori) * *ori;
   } else {
     *pos += ClickPositionAdjustment(interaction, *pos, *ori, gain_pos);
   }
 }
 
+template <typename InteractionT>
 inline Eigen::Vector3d KeypressPositionAdjustment(
-    const Interaction& interaction, double gain = 1e-4) {
+    const InteractionT& interaction, double gain = 1e-4) {
   if (interaction.key_down.empty()) return Eigen::Vector3d::Zero();
 
   size_t idx = 0;
@@ -187,8 +432,9 @@ inline Eigen::Vector3d KeypressPositionAdjustment(
   return sign * gain * Eigen::Vector3d::Unit(idx);
 }
 
+template <typename InteractionT>
 inline Eigen::AngleAxisd KeypressOrientationAdjustment(
-    const Interaction& interaction, double gain = 1e-3) {
+    const InteractionT& interaction, double gain = 1e-3) {
   if (interaction.key_down.empty()) return Eigen::AngleAxisd::Identity();
 
   size_t idx = 0;
@@ -307,6 +553,9 @@ inline void RegisterModelKeys(ctrl_utils::RedisClient& redis,
   args["key_objects_prefix"] = model_keys.key_objects_prefix;
   args["key_trajectories_prefix"] = model_keys.key_trajectories_prefix;
   args["key_cameras_prefix"] = model_keys.key_cameras_prefix;
+  args["key_object_batches_prefix"] = model_keys.key_object_batches_prefix;
+  args["key_descriptions_prefix"] = model_keys.key_descriptions_prefix;
+  args["key_frame"] = model_keys.key_frame;
   redis.set(KEY_ARGS + "::" + model_keys.key_namespace, args);
   if (commit) redis.commit();
 }
@@ -318,20 +567,225 @@ inline void UnregisterModelKeys(ctrl_utils::RedisClient& redis,
   if (commit) redis.commit();
 }
 
-inline void ClearModelKeys(ctrl_utils::RedisClient& redis,
-                           const ModelKeys& model_keys, bool commit = true) {
-  std::array<std::future<std::unordered_set<std::string>>, 4> fut_keys = {
+/**
+ * Maximum number of keys sent in a single UNLINK command.
+ */
+constexpr size_t kUnlinkBatchSize = 512;
+
+/**
+ * Number of times model keys have been unregistered in this process.
+ *
+ * Caches of registered models, like ModelCache, compare it against the value
+ * they were filled with to notice that their keys may have been deleted.
+ */
+inline std::atomic<uint64_t>& ModelKeysGeneration() {
+  static std::atomic<uint64_t> generation = {0};
+  return generation;
+}
+
+/**
+ * Adds a model key to the namespace registry.
+ *
+ * All Register* functions call this so that the models of a namespace can be
+ * listed and cleared without scanning the keyspace.
+ */
+inline void AddToRegistry(ctrl_utils::RedisClient& redis,
+                          const ModelKeys& model_keys, const std::string& key) {
+  redis.sadd(model_keys.key_registry, {key});
+}
+
+/**
+ * Removes a model key from the namespace registry.
+ */
+inline void RemoveFromRegistry(ctrl_utils::RedisClient& redis,
+                               const ModelKeys& model_keys,
+                               const std::string& key) {
+  redis.srem(model_keys.key_registry, {key});
+  ModelKeysGeneration()++;
+}
+
+/**
+ * Sets a model key and adds it to the namespace registry.
+ */
+template <ModelType Type>
+inline void RegisterModel(ctrl_utils::RedisClient& redis,
+                          const ModelKeys& model_keys,
+                          const ModelKey<Type>& key,
+                          const nlohmann::json& model, bool commit = false) {
+  redis.set(key.key(), model);
+  AddToRegistry(redis, model_keys, key);
+  if (commit) redis.commit();
+}
+
+/**
+ * Deletes a model key and removes it from the namespace registry.
+ */
+template <ModelType Type>
+inline void UnregisterModel(ctrl_utils::RedisClient& redis,
+                            const ModelKeys& model_keys,
+                            const ModelKey<Type>& key, bool commit = false) {
+  redis.del({key.key()});
+  RemoveFromRegistry(redis, model_keys, key);
+  if (commit) redis.commit();
+}
+
+/**
+ * Unlinks the keys in batches of kUnlinkBatchSize.
+ *
+ * UNLINK reclaims memory in a background thread, so large values don't block
+ * the Redis server.
+ */
+template <typename Container>
+inline void UnlinkKeys(ctrl_utils::RedisClient& redis, const Container& keys,
+                       bool commit = false) {
+  std::vector<std::string> command;
+  for (const std::string& key : keys) {
+    if (command.empty()) command.push_back("UNLINK");
+    command.push_back(key);
+    if (command.size() > kUnlinkBatchSize) {
+      redis.send(command, [](cpp_redis::reply&) {});
+      command.clear();
+    }
+  }
+  if (!command.empty()) redis.send(command, [](cpp_redis::reply&) {});
+  if (commit) redis.commit();
+}
+
+/**
+ * Lists the model keys registered in the namespace.
+ *
+ * This costs O(registered models), independent of the size of the keyspace.
+ */
+inline std::future<std::unordered_set<std::string>> ListModelKeys(
+    ctrl_utils::RedisClient& redis, const ModelKeys& model_keys,
+    bool commit = false) {
+  auto promise =
+      std::make_shared<std::promise<std::unordered_set<std::string>>>();
+  redis.send({"SMEMBERS", model_keys.key_registry},
+             [promise](cpp_redis::reply& reply) {
+               std::unordered_set<std::string> keys;
+               if (reply.is_array()) {
+                 for (const cpp_redis::reply& key : reply.as_array()) {
+                   if (key.is_string()) keys.insert(key.as_string());
+                 }
+               }
+               promise->set_value(std::move(keys));
+             });
+  if (commit) redis.commit();
+  return promise->get_future();
+}
+
+struct ModelKeysDiff {
+  // Keys that are expected but not registered.
+  std::vector<std::string> added;
+
+  // Keys that are registered but not expected.
+  std::vector<std::string> removed;
+};
+
+/**
+ * Compares the registered model keys against the expected ones.
+ *
+ * @param registered Keys returned by ListModelKeys().
+ * @param expected Keys the app expects to be registered.
+ */
+inline ModelKeysDiff DiffModelKeys(
+    const std::unordered_set<std::string>& registered,
+    const std::unordered_set<std::string>& expected) {
+  ModelKeysDiff diff;
+  for (const std::string& key : expected) {
+    if (registered.find(key) == registered.end()) diff.added.push_back(key);
+  }
+  for (const std::string& key : registered) {
+    if (expected.find(key) == expected.end()) diff.removed.push_back(key);
+  }
+  return diff;
+}
+
+/**
+ * Unregisters all models in the namespace except for the given keys.
+ *
+ * This blocks until the registry has been fetched.
+ */
+inline void PruneModelKeys(ctrl_utils::RedisClient& redis,
+                           const ModelKeys& model_keys,
+                           const std::unordered_set<std::string>& keys,
+                           bool commit = true) {
+  std::future<std::unordered_set<std::string>> fut_registered =
+      ListModelKeys(redis, model_keys, true);
+  const ModelKeysDiff diff = DiffModelKeys(fut_registered.get(), keys);
+  if (diff.removed.empty()) return;
+
+  UnlinkKeys(redis, diff.removed);
+  redis.srem(model_keys.key_registry, diff.removed);
+  ModelKeysGeneration()++;
+  if (commit) redis.commit();
+}
+
+/**
+ * Scans the whole keyspace for the model keys of the namespace.
+ *
+ * This blocks until the scans have finished.
+ */
+inline std::unordered_set<std::string> ScanModelKeys(
+    ctrl_utils::RedisClient& redis, const ModelKeys& model_keys) {
+  std::array<std::future<std::unordered_set<std::string>>, 6> fut_keys = {
       redis.scan(model_keys.key_robots_prefix + "*"),
       redis.scan(model_keys.key_objects_prefix + "*"),
       redis.scan(model_keys.key_trajectories_prefix + "*"),
       redis.scan(model_keys.key_cameras_prefix + "*"),
+      redis.scan(model_keys.key_object_batches_prefix + "*"),
+      redis.scan(model_keys.key_descriptions_prefix + "*"),
   };
   redis.commit();
+  std::unordered_set<std::string> keys;
   for (auto& fut_keys_batch : fut_keys) {
     const auto keys_batch = fut_keys_batch.get();
-    std::vector<std::string> keys;
-    keys.insert(keys.end(), keys_batch.begin(), keys_batch.end());
-    redis.del(keys);
+    keys.insert(keys_batch.begin(), keys_batch.end());
+  }
+  return keys;
+}
+
+/**
+ * Unregisters all models in the namespace.
+ *
+ * This blocks until the registry has been fetched and costs O(registered
+ * models). Models registered without the registry (e.g. by older versions of
+ * this library) are only found with `scan_legacy`, which scans the whole
+ * keyspace. Alternatively, index them once with RebuildRegistry().
+ *
+ * @param scan_legacy Also delete model keys missing from the registry.
+ */
+inline void ClearModelKeys(ctrl_utils::RedisClient& redis,
+                           const ModelKeys& model_keys, bool commit = true,
+                           bool scan_legacy = false) {
+  std::future<std::unordered_set<std::string>> fut_keys =
+      ListModelKeys(redis, model_keys, true);
+  std::unordered_set<std::string> keys = fut_keys.get();
+  if (scan_legacy) {
+    const std::unordered_set<std::string> keys_legacy =
+        ScanModelKeys(redis, model_keys);
+    keys.insert(keys_legacy.begin(), keys_legacy.end());
+  }
+  UnlinkKeys(redis, keys);
+  redis.send({"UNLINK", model_keys.key_registry}, [](cpp_redis::reply&) {});
+  ModelKeysGeneration()++;
+  if (commit) redis.commit();
+}
+
+/**
+ * Adds all existing model keys in the namespace to the registry.
+ *
+ * This scans the whole keyspace and should only be used once to migrate
+ * models registered before the registry existed.
+ */
+inline void RebuildRegistry(ctrl_utils::RedisClient& redis,
+                            const ModelKeys& model_keys, bool commit = true) {
+  const std::unordered_set<std::string> keys =
+      ScanModelKeys(redis, model_keys);
+  if (!keys.empty()) {
+    redis.sadd(model_keys.key_registry,
+               std::vector<std::string>(keys.begin(), keys.end()));
   }
   if (commit) redis.commit();
 }
@@ -343,8 +797,23 @@ inline void RegisterTrajectory(ctrl_utils::RedisClient& redis,
                                bool commit = false) {
   nlohmann::json model;
   model["key_pos"] = key_pos;
-  redis.set(model_keys.key_trajectories_prefix + name, model);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys, TrajectoryKey(model_keys, name), model,
+                commit);
+}
+
+inline void RegisterTrajectory(ctrl_utils::RedisClient& redis,
+                               const ModelKeys& model_keys,
+                               const TrajectoryModel& trajectory,
+                               bool commit = false) {
+  RegisterModel(redis, model_keys, TrajectoryKey(model_keys, trajectory.name),
+                nlohmann::json(trajectory), commit);
+}
+
+inline void UnregisterTrajectory(ctrl_utils::RedisClient& redis,
+                                 const ModelKeys& model_keys,
+                                 const std::string& name,
+                                 bool commit = false) {
+  UnregisterModel(redis, model_keys, TrajectoryKey(model_keys, name), commit);
 }
 
 inline void RegisterCamera(ctrl_utils::RedisClient& redis,
@@ -361,16 +830,20 @@ inline void RegisterCamera(ctrl_utils::RedisClient& redis,
   model["key_intrinsic"] = key_intrinsic;
   model["key_depth_image"] = key_depth_image;
   model["key_color_image"] = key_color_image;
-  redis.set(model_keys.key_cameras_prefix + name, model);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys, CameraKey(model_keys, name), model, commit);
 }
 
 inline void RegisterCamera(ctrl_utils::RedisClient& redis,
                            const ModelKeys& model_keys,
                            const CameraModel& camera, bool commit = false) {
-  nlohmann::json json(camera);
-  redis.set(model_keys.key_cameras_prefix + camera.name, json);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys, CameraKey(model_keys, camera.name),
+                nlohmann::json(camera), commit);
+}
+
+inline void UnregisterCamera(ctrl_utils::RedisClient& redis,
+                             const ModelKeys& model_keys,
+                             const std::string& name, bool commit = false) {
+  UnregisterModel(redis, model_keys, CameraKey(model_keys, name), commit);
 }
 
 // std::future<Interaction> GetInteraction(ctrl_utils::RedisClient& redis, bool
@@ -12,6 +12,16 @@
 
 #include "redis_gl/redis_gl.h"
 
+// std
+#include <cstdint>        // uint8_t, uint32_t
+#include <cstring>        // std::memcpy, std::memset
+#include <deque>          // std::deque
+#include <map>            // std::map
+#include <memory>         // std::shared_ptr
+#include <string_view>    // std::string_view
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
 // external
 #include <spatial_dyn/algorithms/forward_kinematics.h>
 #include <spatial_dyn/parsers/json.h>
@@ -65,6 +75,11 @@ struct RobotModel {
   std::string key_q;
   std::string key_pos;
   std::string key_ori;
+
+  // Optional key of the link transforms published by LinkTransformPublisher.
+  // If set, the viewer applies these transforms instead of computing forward
+  // kinematics from key_q.
+  std::string key_link_transforms;
 };
 
 inline void from_json(const nlohmann::json& json, RobotModel& robot) {
@@ -73,6 +88,8 @@ inline void from_json(const nlohmann::json& json, RobotModel& robot) {
   robot.key_q = json.at("key_q").get<std::string>();
   robot.key_pos = json.at("key_pos").get<std::string>();
   robot.key_ori = json.at("key_ori").get<std::string>();
+  robot.key_link_transforms =
+      json.value("key_link_transforms", std::string());
 }
 
 inline void to_json(nlohmann::json& json, const RobotModel& robot) {
@@ -80,6 +97,9 @@ inline void to_json(nlohmann::json& json, const RobotModel& robot) {
   json["key_q"] = robot.key_q;
   json["key_pos"] = robot.key_pos;
   json["key_ori"] = robot.key_ori;
+  if (!robot.key_link_transforms.empty()) {
+    json["key_link_transforms"] = robot.key_link_transforms;
+  }
 }
 
 inline std::stringstream& operator<<(std::stringstream& ss,
@@ -96,16 +116,118 @@ inline std::stringstream& operator>>(std::stringstream& ss,
   return ss;
 }
 
-inline std::map<size_t, spatial_dyn::SpatialForced> ComputeExternalForces(
-    const redis_gl::simulator::ModelKeys& model_keys,
-    const spatial_dyn::ArticulatedBody& ab,
-    const redis_gl::simulator::Interaction& interaction, double gain = 100.) {
-  std::map<size_t, spatial_dyn::SpatialForced> f_ext;
+/**
+ * Packed link transform format published by LinkTransformPublisher.
+ *
+ * The buffer starts with a 16-byte little-endian header:
+ *
+ *     0  uint8[4] magic "\xffRGK"
+ *     4  uint8    version
+ *     5  uint8[3] reserved
+ *     8  uint32   number of links N
+ *     12 uint32   reserved
+ *
+ * followed by N column-major 4x4 float32 transforms from each link to the
+ * robot base, in rigid body order. The layout matches THREE.Matrix4, so the
+ * viewer copies each transform without any kinematics.
+ */
+constexpr char kLinkTransformsMagic[4] = {'\xff', 'R', 'G', 'K'};
+constexpr uint8_t kLinkTransformsVersion = 1;
+constexpr size_t kLinkTransformsHeaderSize = 16;
 
-  // Check if the clicked object is the robot
-  if (interaction.key_object != model_keys.key_robots_prefix + ab.name)
-    return f_ext;
+/**
+ * Packs the link-to-base transforms of an articulated body whose joint
+ * positions have already been set with set_q().
+ */
+inline void PackLinkTransforms(const spatial_dyn::ArticulatedBody& ab,
+                               std::string* buffer) {
+  constexpr size_t kNumBytesTransform = 16 * sizeof(float);
+  const size_t num_links = ab.size();
+  buffer->resize(kLinkTransformsHeaderSize + num_links * kNumBytesTransform);
 
+  char* data = &(*buffer)[0];
+  std::memset(data, 0, kLinkTransformsHeaderSize);
+  std::memcpy(data, kLinkTransformsMagic, sizeof(kLinkTransformsMagic));
+  data[4] = static_cast<char>(kLinkTransformsVersion);
+  const uint32_t num_links_u32 = static_cast<uint32_t>(num_links);
+  std::memcpy(data + 8, &num_links_u32, sizeof(num_links_u32));
+
+  // The forward kinematics cached by set_q() include the base pose, which the
+  // viewer applies separately.
+  const Eigen::Isometry3d T_world_to_base = ab.T_base_to_world().inverse();
+  data += kLinkTransformsHeaderSize;
+  for (size_t i = 0; i < num_links; i++) {
+    const Eigen::Matrix4f T_to_base =
+        (T_world_to_base * ab.T_to_world(i)).matrix().cast<float>();
+    std::memcpy(data, T_to_base.data(), kNumBytesTransform);
+    data += kNumBytesTransform;
+  }
+}
+
+/**
+ * Publishes the link transforms of robots computed with spatial_dyn forward
+ * kinematics, so that viewers only copy matrices instead of running their own
+ * kinematics for every robot in every tab.
+ *
+ * Robots must be registered with `RobotModel::key_link_transforms`.
+ *
+ * Example:
+ *
+ *     LinkTransformPublisher publisher;
+ *     while (true) {
+ *       for (RobotModel& robot : fleet) robot.articulated_body->set_q(q);
+ *       publisher.Publish(redis, fleet);
+ *       redis.commit();
+ *     }
+ */
+class LinkTransformPublisher {
+ public:
+  /**
+   * Publishes the link transforms of one robot.
+   */
+  void Publish(ctrl_utils::RedisClient& redis, const RobotModel& robot,
+               bool commit = false) {
+    if (robot.key_link_transforms.empty()) return;
+    command_.resize(3);
+    command_[0] = "SET";
+    command_[1] = robot.key_link_transforms;
+    PackLinkTransforms(*robot.articulated_body, &command_[2]);
+    redis.send(command_, [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+  }
+
+  /**
+   * Publishes the link transforms of a fleet of robots in one MSET command.
+   */
+  void Publish(ctrl_utils::RedisClient& redis,
+               const std::vector<RobotModel>& robots, bool commit = false) {
+    // Pack in place so the buffers are reused across calls
+    size_t idx = 1;
+    for (const RobotModel& robot : robots) {
+      if (robot.key_link_transforms.empty()) continue;
+      if (command_.size() < idx + 2) command_.resize(idx + 2);
+      command_[idx] = robot.key_link_transforms;
+      PackLinkTransforms(*robot.articulated_body, &command_[idx + 1]);
+      idx += 2;
+    }
+    if (idx == 1) return;
+    command_.resize(idx);
+    command_[0] = "MSET";
+    redis.send(command_, [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+  }
+
+ private:
+  std::vector<std::string> command_;
+};
+
+/**
+ * Computes the spatial force in the world frame applied by a mouse click.
+ */
+template <typename InteractionT>
+inline spatial_dyn::SpatialForced ComputeClickForce(
+    const spatial_dyn::ArticulatedBody& ab, const InteractionT& interaction,
+    double gain = 100.) {
   // Get the click position in world coordinates
   const Eigen::Vector3d pos_click_in_world = spatial_dyn::Position(
       ab, interaction.idx_link, interaction.pos_click_in_link);
@@ -116,18 +238,165 @@ inline std::map<size_t, spatial_dyn::SpatialForced> ComputeExternalForces(
   spatial_dyn::SpatialForced f_click(f, Eigen::Vector3d::Zero());
 
   // Translate the spatial force to the world frame
-  f_ext[interaction.idx_link] =
-      Eigen::Translation3d(pos_click_in_world) * f_click;
+  return Eigen::Translation3d(pos_click_in_world) * f_click;
+}
 
+template <typename InteractionT>
+inline std::map<size_t, spatial_dyn::SpatialForced> ComputeExternalForces(
+    const redis_gl::simulator::ModelKeys& model_keys,
+    const spatial_dyn::ArticulatedBody& ab,
+    const InteractionT& interaction, double gain = 100.) {
+  std::map<size_t, spatial_dyn::SpatialForced> f_ext;
+
+  // Check if the clicked object is the robot
+  if (!IsModelKey(interaction.key_object, model_keys.key_robots_prefix,
+                  ab.name)) {
+    return f_ext;
+  }
+
+  f_ext[interaction.idx_link] = ComputeClickForce(ab, interaction, gain);
   return f_ext;
 }
 
+/**
+ * Preallocates an external force entry for every link of the articulated body.
+ *
+ * Maps initialized this way can be passed to the ComputeExternalForces()
+ * overloads that write into caller-owned containers without allocating.
+ */
+inline void InitializeExternalForces(
+    const spatial_dyn::ArticulatedBody& ab,
+    std::map<size_t, spatial_dyn::SpatialForced>* f_ext) {
+  for (size_t i = 0; i < ab.size(); i++) {
+    (*f_ext)[i].setZero();
+  }
+}
+
+/**
+ * Computes the external forces into a caller-owned map.
+ *
+ * All existing entries are zeroed and the clicked link's entry is set. If the
+ * map was preallocated with InitializeExternalForces(), this function does
+ * not allocate memory.
+ *
+ * @return True if the interaction targets this robot.
+ */
+template <typename InteractionT>
+inline bool ComputeExternalForces(
+    const redis_gl::simulator::ModelKeys& model_keys,
+    const spatial_dyn::ArticulatedBody& ab, const InteractionT& interaction,
+    std::map<size_t, spatial_dyn::SpatialForced>* f_ext, double gain = 100.) {
+  for (auto& idx_f : *f_ext) {
+    idx_f.second.setZero();
+  }
+
+  // Check if the clicked object is the robot
+  if (!IsModelKey(interaction.key_object, model_keys.key_robots_prefix,
+                  ab.name)) {
+    return false;
+  }
+
+  (*f_ext)[interaction.idx_link] = ComputeClickForce(ab, interaction, gain);
+  return true;
+}
+
+/**
+ * Precomputed lookup from interaction object keys to registered robots.
+ *
+ * Robot keys are built once on construction, so resolving the target of an
+ * interaction is a single hash lookup without string allocation.
+ */
+class RobotKeyIndex {
+ public:
+  explicit RobotKeyIndex(const ModelKeys& model_keys)
+      : model_keys_(model_keys) {}
+
+  RobotKeyIndex(
+      const ModelKeys& model_keys,
+      const std::vector<const spatial_dyn::ArticulatedBody*>& abs)
+      : model_keys_(model_keys) {
+    for (const spatial_dyn::ArticulatedBody* ab : abs) Add(*ab);
+  }
+
+  RobotKeyIndex(const RobotKeyIndex&) = delete;
+  RobotKeyIndex& operator=(const RobotKeyIndex&) = delete;
+
+  /**
+   * Adds a robot to the index. The articulated body must outlive the index.
+   *
+   * @return Index of the robot.
+   */
+  size_t Add(const spatial_dyn::ArticulatedBody& ab) {
+    const size_t idx = abs_.size();
+    keys_.push_back(RobotKey(model_keys_, ab.name));
+    abs_.push_back(&ab);
+    idx_keys_[keys_.back()] = idx;
+    return idx;
+  }
+
+  /**
+   * Finds the robot with the given key.
+   *
+   * @return Index of the robot, or -1 if the key doesn't belong to a robot.
+   */
+  int Find(std::string_view key_object) const {
+    if (key_object.empty()) return -1;
+    const auto it = idx_keys_.find(key_object);
+    return it == idx_keys_.end() ? -1 : static_cast<int>(it->second);
+  }
+
+  size_t size() const { return abs_.size(); }
+
+  const spatial_dyn::ArticulatedBody& articulated_body(size_t idx) const {
+    return *abs_[idx];
+  }
+
+  const std::string& key(size_t idx) const { return keys_[idx]; }
+
+ private:
+  ModelKeys model_keys_;
+
+  // Deque keeps the keys referenced by idx_keys_ at stable addresses.
+  std::deque<std::string> keys_;
+  std::vector<const spatial_dyn::ArticulatedBody*> abs_;
+  std::unordered_map<std::string_view, size_t> idx_keys_;
+};
+
+/**
+ * Computes the external forces for all robots in the index.
+ *
+ * The output vector holds one map per robot, in index order. If each map was
+ * preallocated with InitializeExternalForces(), this function does not
+ * allocate memory.
+ *
+ * @return Index of the robot targeted by the interaction, or -1 if none.
+ */
+template <typename InteractionT>
+inline int ComputeExternalForces(
+    const RobotKeyIndex& robots, const InteractionT& interaction,
+    std::vector<std::map<size_t, spatial_dyn::SpatialForced>>* f_exts,
+    double gain = 100.) {
+  f_exts->resize(robots.size());
+  for (auto& f_ext : *f_exts) {
+    for (auto& idx_f : f_ext) {
+      idx_f.second.setZero();
+    }
+  }
+
+  const int idx_robot = robots.Find(interaction.key_object);
+  if (idx_robot < 0) return -1;
+
+  (*f_exts)[idx_robot][interaction.idx_link] =
+      ComputeClickForce(robots.articulated_body(idx_robot), interaction, gain);
+  return idx_robot;
+}
+
 inline void RegisterRobot(ctrl_utils::RedisClient& redis,
                           const ModelKeys& model_keys, const RobotModel& robot,
                           bool commit = false) {
-  nlohmann::json json(robot);
-  redis.set(model_keys.key_robots_prefix + robot.articulated_body->name, json);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys,
+                RobotKey(model_keys, robot.articulated_body->name),
+                nlohmann::json(robot), commit);
 }
 
 inline void RegisterRobot(ctrl_utils::RedisClient& redis,
@@ -142,8 +411,14 @@ inline void RegisterRobot(ctrl_utils::RedisClient& redis,
   model["key_q"] = key_q;
   model["key_pos"] = key_pos;
   model["key_ori"] = key_ori;
-  redis.set(model_keys.key_robots_prefix + ab.name, model);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys, RobotKey(model_keys, ab.name), model,
+                commit);
+}
+
+inline void UnregisterRobot(ctrl_utils::RedisClient& redis,
+                            const ModelKeys& model_keys,
+                            const std::string& name, bool commit = false) {
+  UnregisterModel(redis, model_keys, RobotKey(model_keys, name), commit);
 }
 
 inline void RegisterObject(ctrl_utils::RedisClient& redis,
@@ -161,8 +436,7 @@ inline void RegisterObject(ctrl_utils::RedisClient& redis,
   model["key_scale"] = key_scale;
   model["key_matrix"] = key_matrix;
   model["axis_size"] = axis_size;
-  redis.set(model_keys.key_objects_prefix + name, model);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys, ObjectKey(model_keys, name), model, commit);
 }
 
 inline void RegisterObject(ctrl_utils::RedisClient& redis,
@@ -180,22 +454,21 @@ inline void RegisterObject(ctrl_utils::RedisClient& redis,
   model["key_scale"] = key_scale;
   model["key_matrix"] = key_matrix;
   model["axis_size"] = axis_size;
-  redis.set(model_keys.key_objects_prefix + graphics.name, model);
-  if (commit) redis.commit();
+  RegisterModel(redis, model_keys, ObjectKey(model_keys, graphics.name), model,
+                commit);
 }
 
 inline void RegisterObject(ctrl_utils::RedisClient& redis,
                            const ModelKeys& model_keys,
                            const ObjectModel& object, bool commit = false) {
-  nlohmann::json json(object);
-  redis.set(model_keys.key_objects_prefix + object.name, json);
+  RegisterModel(redis, model_keys, ObjectKey(model_keys, object.name),
+                nlohmann::json(object), commit);
 }
 
 inline void UnregisterObject(ctrl_utils::RedisClient& redis,
                              const ModelKeys& model_keys,
                              const std::string& name, bool commit = false) {
-  redis.del({model_keys.key_objects_prefix + name});
-  if (commit) redis.commit();
+  UnregisterModel(redis, model_keys, ObjectKey(model_keys, name), commit);
 }
 
 }  // namespace simulator
@@ -0,0 +1,168 @@
+/**
+ * scene.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_SCENE_H_
+#define REDIS_GL_SCENE_H_
+
+#include "redis_gl/robot.h"
+
+// std
+#include <algorithm>  // std::max, std::min
+#include <chrono>     // std::chrono
+#include <exception>  // std::exception_ptr, std::rethrow_exception
+#include <string>     // std::string
+#include <thread>     // std::thread
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Timing report of RegisterScene().
+ */
+struct RegisterSceneStats {
+  // Number of registered models
+  size_t num_models = 0;
+
+  // Total size of the serialized models in bytes
+  size_t num_bytes = 0;
+
+  // Number of threads used for serialization
+  size_t num_threads = 0;
+
+  // Time spent serializing the models to json
+  std::chrono::duration<double> t_serialize = {};
+
+  // Time spent sending the batch and waiting for the Redis replies. This is
+  // zero if the batch wasn't committed.
+  std::chrono::duration<double> t_commit = {};
+};
+
+/**
+ * Registers all models of a scene at once.
+ *
+ * The models are serialized in parallel and sent as a single pipelined batch
+ * of one MSET and one registry SADD. The resulting keys are identical to those
+ * of the individual Register* functions.
+ *
+ * @param redis Redis client.
+ * @param model_keys Namespace of the models.
+ * @param robots Robot models.
+ * @param objects Object models.
+ * @param cameras Camera models.
+ * @param trajectories Trajectory models.
+ * @param num_threads Number of serialization threads. If 0, uses the number
+ *                    of hardware threads.
+ * @param commit Commit the batch synchronously and time the round trip.
+ * @return Timing report.
+ * @throws nlohmann::json::exception if a model cannot be serialized (e.g. a
+ *         name that is not valid UTF-8). Nothing is sent in that case.
+ */
+inline RegisterSceneStats RegisterScene(
+    ctrl_utils::RedisClient& redis, const ModelKeys& model_keys,
+    const std::vector<RobotModel>& robots,
+    const std::vector<ObjectModel>& objects,
+    const std::vector<CameraModel>& cameras = {},
+    const std::vector<TrajectoryModel>& trajectories = {},
+    size_t num_threads = 0, bool commit = true) {
+  using Clock = std::chrono::steady_clock;
+
+  RegisterSceneStats stats;
+  stats.num_models =
+      robots.size() + objects.size() + cameras.size() + trajectories.size();
+  if (stats.num_models == 0) return stats;
+
+  // Each model is written to a fixed slot so threads never share state
+  std::vector<std::pair<std::string, std::string>> key_vals(stats.num_models);
+  const size_t idx_objects = robots.size();
+  const size_t idx_cameras = idx_objects + objects.size();
+  const size_t idx_trajectories = idx_cameras + cameras.size();
+  auto Serialize = [&](size_t idx) {
+    std::pair<std::string, std::string>& key_val = key_vals[idx];
+    if (idx < idx_objects) {
+      const RobotModel& robot = robots[idx];
+      key_val.first = RobotKey(model_keys, robot.articulated_body->name).key();
+      key_val.second = nlohmann::json(robot).dump();
+    } else if (idx < idx_cameras) {
+      const ObjectModel& object = objects[idx - idx_objects];
+      key_val.first = ObjectKey(model_keys, object.name).key();
+      key_val.second = nlohmann::json(object).dump();
+    } else if (idx < idx_trajectories) {
+      const CameraModel& camera = cameras[idx - idx_cameras];
+      key_val.first = CameraKey(model_keys, camera.name).key();
+      key_val.second = nlohmann::json(camera).dump();
+    } else {
+      const TrajectoryModel& trajectory =
+          trajectories[idx - idx_trajectories];
+      key_val.first = TrajectoryKey(model_keys, trajectory.name).key();
+      key_val.second = nlohmann::json(trajectory).dump();
+    }
+  };
+
+  // Serialize models in parallel with a strided partition, since model sizes
+  // vary widely (robots are much larger than objects).
+  const Clock::time_point t_start = Clock::now();
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, stats.num_models);
+  stats.num_threads = num_threads;
+  // Exceptions are rethrown on the calling thread after all threads joined
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto SerializePartition = [&](size_t t) {
+    try {
+      for (size_t i = t; i < stats.num_models; i += num_threads) Serialize(i);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(SerializePartition, t);
+  }
+  SerializePartition(0);
+  for (std::thread& thread : threads) thread.join();
+  for (const std::exception_ptr& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  stats.t_serialize = Clock::now() - t_start;
+
+  // Build batch
+  std::vector<std::string> command_mset;
+  std::vector<std::string> command_sadd;
+  command_mset.reserve(2 * stats.num_models + 1);
+  command_sadd.reserve(stats.num_models + 2);
+  command_mset.push_back("MSET");
+  command_sadd.push_back("SADD");
+  command_sadd.push_back(model_keys.key_registry);
+  for (std::pair<std::string, std::string>& key_val : key_vals) {
+    stats.num_bytes += key_val.second.size();
+    command_sadd.push_back(key_val.first);
+    command_mset.push_back(std::move(key_val.first));
+    command_mset.push_back(std::move(key_val.second));
+  }
+  redis.send(command_mset, [](cpp_redis::reply&) {});
+  redis.send(command_sadd, [](cpp_redis::reply&) {});
+
+  if (commit) {
+    const Clock::time_point t_commit = Clock::now();
+    redis.sync_commit();
+    stats.t_commit = Clock::now() - t_commit;
+  }
+  return stats;
+}
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_SCENE_H_
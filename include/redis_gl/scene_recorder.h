@@ -0,0 +1,878 @@
+/**
+ * scene_recorder.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_SCENE_RECORDER_H_
+#define REDIS_GL_SCENE_RECORDER_H_
+
+#include "redis_gl/scene_snapshot.h"
+
+// std
+#include <algorithm>      // std::max, std::min, std::upper_bound
+#include <atomic>         // std::atomic
+#include <chrono>         // std::chrono
+#include <cstdint>        // int64_t, uint8_t, uint32_t, uint64_t
+#include <cstring>        // std::memcpy, std::memset
+#include <exception>      // std::exception_ptr, std::rethrow_exception
+#include <fstream>        // std::ofstream
+#include <functional>     // std::ref
+#include <mutex>          // std::lock_guard, std::mutex
+#include <optional>       // std::nullopt, std::optional
+#include <stdexcept>      // std::invalid_argument, std::runtime_error
+#include <string>         // std::string
+#include <string_view>    // std::string_view
+#include <thread>         // std::thread
+#include <unordered_map>  // std::unordered_map
+#include <unordered_set>  // std::unordered_set
+#include <vector>         // std::vector
+
+// posix
+#include <errno.h>     // errno, ENOENT
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, ftruncate, sysconf
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Scene log written by SceneRecorder.
+ *
+ * The log starts with a 16-byte little-endian header:
+ *
+ *     0  uint8[4] magic "\xffRGS"
+ *     4  uint8    version
+ *     5  uint8[3] reserved
+ *     8  int64    start time in ns since the epoch
+ *
+ * followed by records, each with a 24-byte header and a payload padded to 8
+ * bytes:
+ *
+ *     0  int64    time in ns since the epoch
+ *     8  uint32   key id, or number of entries of a keyframe
+ *     12 uint8    type (SceneRecordType)
+ *     13 uint8[3] reserved
+ *     16 uint32   payload size
+ *     20 uint32   reserved
+ *
+ * A kKey record defines the name of a key id before its first value. A
+ * kKeyframe record lists, for every key recorded so far, the offsets of its
+ * kKey record and latest kValue record (or 0 if deleted):
+ *
+ *     0  uint32   key id
+ *     4  uint32   reserved
+ *     8  uint64   offset of the kKey record
+ *     16 uint64   offset of the kValue record
+ *
+ * Keyframes only point back into the log, so they are small and can be
+ * written often. The index file "<log>.index" has a 16-byte header with the
+ * magic "\xffRGX" and version, followed by an int64 time and uint64 offset of
+ * each keyframe.
+ */
+constexpr char kSceneLogMagic[4] = {'\xff', 'R', 'G', 'S'};
+constexpr char kSceneIndexMagic[4] = {'\xff', 'R', 'G', 'X'};
+constexpr uint8_t kSceneLogVersion = 1;
+constexpr size_t kSceneLogHeaderSize = 16;
+constexpr size_t kSceneRecordHeaderSize = 24;
+constexpr size_t kSceneKeyframeEntrySize = 24;
+
+enum class SceneRecordType : uint8_t {
+  kKey = 1,
+  kValue = 2,
+  kDelete = 3,
+  kKeyframe = 4
+};
+
+namespace internal {
+
+struct SceneRecord {
+  int64_t t;
+  uint32_t id;
+  SceneRecordType type;
+  std::string_view payload;
+
+  // Offset of the next record.
+  size_t offset_next;
+};
+
+struct SceneIndexEntry {
+  int64_t t;
+  uint64_t offset;
+};
+
+inline size_t SceneRecordSize(size_t payload_size) {
+  return kSceneRecordHeaderSize + ((payload_size + 7) & ~size_t{7});
+}
+
+/**
+ * Parses the record at the offset.
+ *
+ * @return False at the end of the log, including the zero-filled tail of an
+ *         interrupted recording.
+ */
+inline bool ReadSceneRecord(const char* data, size_t size, size_t offset,
+                            SceneRecord* record) {
+  if (offset + kSceneRecordHeaderSize > size) return false;
+  const char* header = data + offset;
+  uint32_t payload_size;
+  std::memcpy(&record->t, header, sizeof(record->t));
+  std::memcpy(&record->id, header + 8, sizeof(record->id));
+  record->type = static_cast<SceneRecordType>(header[12]);
+  std::memcpy(&payload_size, header + 16, sizeof(payload_size));
+  if (record->type < SceneRecordType::kKey ||
+      record->type > SceneRecordType::kKeyframe) {
+    return false;
+  }
+
+  record->offset_next = offset + SceneRecordSize(payload_size);
+  if (record->offset_next > size) return false;
+  record->payload =
+      std::string_view(header + kSceneRecordHeaderSize, payload_size);
+  return true;
+}
+
+/**
+ * Read-only memory map of a whole file.
+ */
+class MappedFile {
+ public:
+  /**
+   * @param missing_ok Map a missing file as empty instead of throwing.
+   */
+  explicit MappedFile(const std::string& path, bool missing_ok = false) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      if (missing_ok && errno == ENOENT) return;
+      throw std::runtime_error("MappedFile(): could not open " + path + ".");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0) size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+      void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("MappedFile(): could not map " + path + ".");
+      }
+      data_ = static_cast<const char*>(data);
+    }
+    ::close(fd);
+  }
+
+  ~MappedFile() {
+    if (data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+inline int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace internal
+
+/**
+ * Records the state of a scene to an append-only scene log for SceneReplayer.
+ *
+ * Start() records a namespace in a background thread: it rescans the
+ * registered models (robots, objects, trajectories, cameras, ...) with
+ * GetScene() every rescan period, and samples all of their state keys with
+ * one MGET at the given rate. Only values that changed are written, and keys
+ * that disappear are recorded as deleted. Values can also be recorded
+ * directly with Record().
+ *
+ * The log is written through a sliding memory-mapped window, so recording for
+ * hours uses bounded memory. A keyframe and index entry are written every
+ * keyframe period for seeking.
+ *
+ * Example:
+ *
+ *     ctrl_utils::RedisClient redis_recorder;
+ *     redis_recorder.connect();
+ *     SceneRecorder recorder("scene.rgs");
+ *     recorder.Start(redis_recorder, model_keys);
+ *
+ * If the background thread fails (e.g. the Redis connection drops or the disk
+ * is full), it stops recording, and Stop() rethrows the error.
+ */
+class SceneRecorder {
+ public:
+  /**
+   * Creates the log, replacing any existing log at the path.
+   *
+   * @param path Log path. The index is written to "<path>.index".
+   * @param keyframe_period Time between keyframes in seconds.
+   */
+  explicit SceneRecorder(const std::string& path,
+                         double keyframe_period = 1.)
+      : keyframe_period_(static_cast<int64_t>(1e9 * keyframe_period)),
+        page_size_(static_cast<size_t>(::sysconf(_SC_PAGESIZE))) {
+    if (keyframe_period <= 0.) {
+      throw std::invalid_argument(
+          "SceneRecorder(): keyframe period must be positive.");
+    }
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      throw std::runtime_error("SceneRecorder(): could not open " + path +
+                               ".");
+    }
+    index_.open(path + ".index", std::ios::binary | std::ios::trunc);
+    if (!index_) {
+      ::close(fd_);
+      throw std::runtime_error("SceneRecorder(): could not open " + path +
+                               ".index.");
+    }
+
+    char header[kSceneLogHeaderSize] = {};
+    std::memcpy(header, kSceneIndexMagic, sizeof(kSceneIndexMagic));
+    header[4] = static_cast<char>(kSceneLogVersion);
+    index_.write(header, sizeof(header));
+
+    const int64_t t_start = internal::NowNs();
+    std::memcpy(header, kSceneLogMagic, sizeof(kSceneLogMagic));
+    std::memcpy(header + 8, &t_start, sizeof(t_start));
+    Reserve(kSceneLogHeaderSize);
+    std::memcpy(window_, header, sizeof(header));
+    offset_ = kSceneLogHeaderSize;
+  }
+
+  /**
+   * Stops recording and truncates the log to its final size.
+   */
+  ~SceneRecorder() {
+    Join();
+    if (window_ != nullptr) ::munmap(window_, window_size_);
+
+    // If this fails, SceneReplayer ignores the zero-filled tail
+    const int result = ::ftruncate(fd_, static_cast<off_t>(offset_));
+    static_cast<void>(result);
+    ::close(fd_);
+  }
+
+  SceneRecorder(const SceneRecorder&) = delete;
+  SceneRecorder& operator=(const SceneRecorder&) = delete;
+
+  /**
+   * Starts recording a namespace in a background thread.
+   *
+   * @param redis Connected Redis client used exclusively by the thread.
+   * @param model_keys Namespace of the models.
+   * @param rate Sampling rate of the state keys in Hz.
+   * @param rescan_period Time between rescans of the models in seconds.
+   */
+  void Start(ctrl_utils::RedisClient& redis, const ModelKeys& model_keys,
+             double rate = 60., double rescan_period = 1.) {
+    if (rate <= 0.) {
+      throw std::invalid_argument("SceneRecorder::Start(): rate must be "
+                                  "positive.");
+    }
+    Stop();
+    running_ = true;
+    thread_ = std::thread(&SceneRecorder::Run, this, std::ref(redis),
+                          model_keys, rate, rescan_period);
+  }
+
+  /**
+   * Stops the background thread.
+   *
+   * @throws The error that stopped the background thread, if any.
+   */
+  void Stop() {
+    Join();
+    if (!error_) return;
+    std::exception_ptr error = std::move(error_);
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+
+  /**
+   * Whether the background thread is recording. False after it failed.
+   */
+  bool running() const { return running_; }
+
+  /**
+   * Records the value of a key if it changed.
+   */
+  void Record(const std::string& key, std::string_view value) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    const int64_t t = internal::NowNs();
+    Key& state = FindKey(t, key);
+    if (state.offset_value != 0 && state.value == value) return;
+
+    MaybeWriteKeyframe(t);
+    state.offset_value = Append(t, state.id, SceneRecordType::kValue, value);
+    state.value = value;
+  }
+
+  /**
+   * Records the deletion of a key.
+   */
+  void Delete(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = idx_keys_.find(key);
+    if (it == idx_keys_.end()) return;
+    Key& state = keys_[it->second];
+    if (state.offset_value == 0) return;
+
+    const int64_t t = internal::NowNs();
+    MaybeWriteKeyframe(t);
+    Append(t, state.id, SceneRecordType::kDelete, {});
+    state.offset_value = 0;
+    state.value.clear();
+  }
+
+  /**
+   * Size of the log in bytes.
+   */
+  size_t num_bytes() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return offset_;
+  }
+
+ private:
+  struct Key {
+    uint32_t id;
+    uint64_t offset_key;
+    uint64_t offset_value = 0;
+    std::string value;
+  };
+
+  // Size of the memory-mapped window.
+  static constexpr size_t kWindowSize = 16 << 20;
+
+  Key& FindKey(int64_t t, const std::string& key) {
+    auto it = idx_keys_.find(key);
+    if (it != idx_keys_.end()) return keys_[it->second];
+
+    Key state;
+    state.id = static_cast<uint32_t>(keys_.size());
+    state.offset_key = Append(t, state.id, SceneRecordType::kKey, key);
+    idx_keys_[key] = state.id;
+    keys_.push_back(std::move(state));
+    return keys_.back();
+  }
+
+  void MaybeWriteKeyframe(int64_t t) {
+    if (t < t_keyframe_next_) return;
+    t_keyframe_next_ = t + keyframe_period_;
+
+    keyframe_.resize(kSceneKeyframeEntrySize * keys_.size());
+    char* entry = &keyframe_[0];
+    for (const Key& key : keys_) {
+      std::memset(entry, 0, kSceneKeyframeEntrySize);
+      std::memcpy(entry, &key.id, sizeof(key.id));
+      std::memcpy(entry + 8, &key.offset_key, sizeof(key.offset_key));
+      std::memcpy(entry + 16, &key.offset_value, sizeof(key.offset_value));
+      entry += kSceneKeyframeEntrySize;
+    }
+    const uint64_t offset =
+        Append(t, static_cast<uint32_t>(keys_.size()),
+               SceneRecordType::kKeyframe, keyframe_);
+
+    // Index the keyframe only after it is in the log
+    const internal::SceneIndexEntry index_entry = {t, offset};
+    index_.write(reinterpret_cast<const char*>(&index_entry),
+                 sizeof(index_entry));
+    index_.flush();
+  }
+
+  /**
+   * Appends a record and returns its offset.
+   */
+  uint64_t Append(int64_t t, uint32_t id, SceneRecordType type,
+                  std::string_view payload) {
+    const size_t size = internal::SceneRecordSize(payload.size());
+    Reserve(size);
+
+    char* record = window_ + (offset_ - window_offset_);
+    const uint32_t payload_size = static_cast<uint32_t>(payload.size());
+    std::memset(record, 0, size);
+    std::memcpy(record, &t, sizeof(t));
+    std::memcpy(record + 8, &id, sizeof(id));
+    record[12] = static_cast<char>(type);
+    std::memcpy(record + 16, &payload_size, sizeof(payload_size));
+    if (!payload.empty()) {
+      std::memcpy(record + kSceneRecordHeaderSize, payload.data(),
+                  payload.size());
+    }
+
+    const uint64_t offset = offset_;
+    offset_ += size;
+    return offset;
+  }
+
+  /**
+   * Slides the mapped window so the next num_bytes can be written, growing
+   * the file as needed.
+   */
+  void Reserve(size_t num_bytes) {
+    if (window_ != nullptr &&
+        offset_ + num_bytes <= window_offset_ + window_size_) {
+      return;
+    }
+    if (window_ != nullptr) ::munmap(window_, window_size_);
+    window_ = nullptr;
+
+    window_offset_ = offset_ - offset_ % page_size_;
+    const size_t num_bytes_min = offset_ + num_bytes - window_offset_;
+    const size_t num_pages_min = (num_bytes_min + page_size_ - 1) / page_size_;
+    window_size_ = std::max(kWindowSize, num_pages_min * page_size_);
+    if (::ftruncate(fd_, static_cast<off_t>(window_offset_ + window_size_)) !=
+        0) {
+      throw std::runtime_error("SceneRecorder(): could not grow the log.");
+    }
+    void* window = ::mmap(nullptr, window_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd_, static_cast<off_t>(window_offset_));
+    if (window == MAP_FAILED) {
+      throw std::runtime_error("SceneRecorder(): could not map the log.");
+    }
+    window_ = static_cast<char*>(window);
+  }
+
+  void Join() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+  }
+
+  void Run(ctrl_utils::RedisClient& redis, ModelKeys model_keys, double rate,
+           double rescan_period) {
+    try {
+      Poll(redis, model_keys, rate, rescan_period);
+    } catch (...) {
+      error_ = std::current_exception();
+      running_ = false;
+    }
+  }
+
+  void Poll(ctrl_utils::RedisClient& redis, const ModelKeys& model_keys,
+            double rate, double rescan_period) {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1. / rate));
+    const auto period_rescan = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(rescan_period));
+
+    std::unordered_set<std::string> keys_scene;
+    std::vector<std::string> keys_states;
+    Clock::time_point t_next = Clock::now();
+    Clock::time_point t_rescan = t_next;
+    while (running_) {
+      if (Clock::now() >= t_rescan) {
+        // Record the models and any keys that disappeared from the scene
+        const Scene scene = GetScene(redis, model_keys);
+        std::unordered_set<std::string> keys_scene_new;
+        for (const auto& key_val : scene.models) {
+          Record(key_val.first, key_val.second);
+          keys_scene_new.insert(key_val.first);
+        }
+        keys_scene_new.insert(scene.states.begin(), scene.states.end());
+        for (const std::string& key : keys_scene) {
+          if (keys_scene_new.count(key) == 0) Delete(key);
+        }
+        keys_scene = std::move(keys_scene_new);
+        keys_states = scene.states;
+        t_rescan = Clock::now() + period_rescan;
+      }
+
+      // Sample the state keys, recording missing keys as deleted
+      const auto key_vals = internal::MGet(redis, keys_states);
+      auto it = key_vals.begin();
+      for (const std::string& key : keys_states) {
+        if (it != key_vals.end() && it->first == key) {
+          Record(key, it->second);
+          ++it;
+        } else {
+          Delete(key);
+        }
+      }
+
+      t_next += period;
+      std::this_thread::sleep_until(t_next);
+    }
+  }
+
+  const int64_t keyframe_period_;
+  const size_t page_size_;
+
+  mutable std::mutex mtx_;
+  int fd_ = -1;
+  std::ofstream index_;
+  char* window_ = nullptr;
+  size_t window_offset_ = 0;
+  size_t window_size_ = 0;
+  size_t offset_ = 0;
+
+  std::vector<Key> keys_;
+  std::unordered_map<std::string, uint32_t> idx_keys_;
+  int64_t t_keyframe_next_ = 0;
+  std::string keyframe_;
+
+  std::atomic<bool> running_ = {false};
+  std::thread thread_;
+
+  // Error that stopped the background thread. Read after joining it.
+  std::exception_ptr error_;
+};
+
+/**
+ * Plays a scene log written by SceneRecorder back into Redis.
+ *
+ * Playback can be paused, run at any speed, and seek to any time: a seek
+ * binary searches the index for the last keyframe before the time and only
+ * reads the records after it, so it costs O(log n) in the length of the log.
+ * Each step publishes the latest value of every key that changed with one
+ * MSET (and one DEL for deleted keys).
+ *
+ * The log and index are memory-mapped read-only, so the resident memory of
+ * long logs is managed by the page cache rather than held by the replayer.
+ *
+ * Example:
+ *
+ *     SceneReplayer replayer("scene.rgs");
+ *     replayer.Seek(replayer.duration() - 60.);
+ *     replayer.SetSpeed(0.5);
+ *     replayer.Start(redis);
+ *
+ * A log without its index can still be played back, but seeking reads it from
+ * the start. If the background thread fails (e.g. the Redis connection drops),
+ * it stops playback, and Stop() rethrows the error.
+ */
+class SceneReplayer {
+ public:
+  explicit SceneReplayer(const std::string& path)
+      : log_(path), index_(path + ".index", true) {
+    if (log_.size() < kSceneLogHeaderSize ||
+        std::memcmp(log_.data(), kSceneLogMagic, sizeof(kSceneLogMagic)) !=
+            0 ||
+        static_cast<uint8_t>(log_.data()[4]) != kSceneLogVersion) {
+      throw std::runtime_error("SceneReplayer(): invalid log " + path + ".");
+    }
+    std::memcpy(&t_start_, log_.data() + 8, sizeof(t_start_));
+    if (index_.size() >= kSceneLogHeaderSize) {
+      num_index_ = (index_.size() - kSceneLogHeaderSize) /
+                   sizeof(internal::SceneIndexEntry);
+    }
+
+    // Find the end of the log from the last keyframe
+    t_end_ = t_start_;
+    size_t offset = num_index_ > 0 ? IndexEntry(num_index_ - 1).offset
+                                   : kSceneLogHeaderSize;
+    internal::SceneRecord record;
+    while (internal::ReadSceneRecord(log_.data(), log_.size(), offset,
+                                     &record)) {
+      t_end_ = std::max(t_end_, record.t);
+      offset = record.offset_next;
+    }
+
+    cursor_ = kSceneLogHeaderSize;
+    t_ = t_start_;
+  }
+
+  ~SceneReplayer() { Join(); }
+
+  SceneReplayer(const SceneReplayer&) = delete;
+  SceneReplayer& operator=(const SceneReplayer&) = delete;
+
+  /**
+   * Starts playback in a background thread.
+   *
+   * @param redis Connected Redis client used exclusively by the thread.
+   * @param rate Publishing rate in Hz.
+   */
+  void Start(ctrl_utils::RedisClient& redis, double rate = 60.) {
+    if (rate <= 0.) {
+      throw std::invalid_argument("SceneReplayer::Start(): rate must be "
+                                  "positive.");
+    }
+    Stop();
+    running_ = true;
+    thread_ = std::thread(&SceneReplayer::Run, this, std::ref(redis), rate);
+  }
+
+  /**
+   * Stops the background thread.
+   *
+   * @throws The error that stopped the background thread, if any.
+   */
+  void Stop() {
+    Join();
+    if (!error_) return;
+    std::exception_ptr error = std::move(error_);
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+
+  /**
+   * Whether the background thread is playing. False after it failed.
+   */
+  bool running() const { return running_; }
+
+  /**
+   * Advances playback by dt seconds of wall time times the speed, and
+   * publishes the keys that changed.
+   *
+   * @return False once the end of the log has been published.
+   */
+  bool Step(ctrl_utils::RedisClient& redis, double dt) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!paused_) {
+      t_ = std::min(t_end_, t_ + static_cast<int64_t>(1e9 * speed_ * dt));
+    }
+    ReadUntil(t_);
+    Publish(redis);
+    internal::SceneRecord record;
+    return internal::ReadSceneRecord(log_.data(), log_.size(), cursor_,
+                                     &record);
+  }
+
+  /**
+   * Seeks to a time in seconds from the start of the log. The full state at
+   * that time is published by the next step.
+   */
+  void Seek(double t) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    t_ = std::max(t_start_, std::min(t_end_, t_start_ +
+                                     static_cast<int64_t>(1e9 * t)));
+
+    // Find the last keyframe at or before the time
+    size_t idx_keyframe = 0;
+    if (num_index_ > 0) {
+      const internal::SceneIndexEntry* begin = IndexBegin();
+      const internal::SceneIndexEntry* it = std::upper_bound(
+          begin, begin + num_index_, t_,
+          [](int64_t t, const internal::SceneIndexEntry& entry) {
+            return t < entry.t;
+          });
+      idx_keyframe = it - begin;
+    }
+
+    // Keys published so far that are not in the new state are deleted
+    for (uint32_t id = 0; id < published_.size(); id++) {
+      if (published_[id]) updates_[id] = std::nullopt;
+    }
+
+    if (idx_keyframe == 0) {
+      cursor_ = kSceneLogHeaderSize;
+    } else {
+      internal::SceneRecord keyframe;
+      internal::ReadSceneRecord(log_.data(), log_.size(),
+                                IndexEntry(idx_keyframe - 1).offset,
+                                &keyframe);
+      const char* entry = keyframe.payload.data();
+      for (uint32_t i = 0; i < keyframe.id; i++) {
+        uint32_t id;
+        uint64_t offset_key, offset_value;
+        std::memcpy(&id, entry, sizeof(id));
+        std::memcpy(&offset_key, entry + 8, sizeof(offset_key));
+        std::memcpy(&offset_value, entry + 16, sizeof(offset_value));
+        entry += kSceneKeyframeEntrySize;
+
+        internal::SceneRecord record;
+        internal::ReadSceneRecord(log_.data(), log_.size(), offset_key,
+                                  &record);
+        SetName(id, record.payload);
+        if (offset_value == 0) continue;
+        internal::ReadSceneRecord(log_.data(), log_.size(), offset_value,
+                                  &record);
+        updates_[id] = record.payload;
+      }
+      cursor_ = keyframe.offset_next;
+    }
+    ReadUntil(t_);
+  }
+
+  void Pause() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    paused_ = true;
+  }
+
+  void Play() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    paused_ = false;
+  }
+
+  bool paused() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return paused_;
+  }
+
+  /**
+   * Sets the playback speed relative to the recording, e.g. 0.5 for half
+   * speed.
+   */
+  void SetSpeed(double speed) {
+    if (speed < 0.) {
+      throw std::invalid_argument(
+          "SceneReplayer::SetSpeed(): speed must be non-negative.");
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    speed_ = speed;
+  }
+
+  double speed() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return speed_;
+  }
+
+  /**
+   * Playback time in seconds from the start of the log.
+   */
+  double time() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return 1e-9 * static_cast<double>(t_ - t_start_);
+  }
+
+  /**
+   * Duration of the log in seconds.
+   */
+  double duration() const {
+    return 1e-9 * static_cast<double>(t_end_ - t_start_);
+  }
+
+ private:
+  const internal::SceneIndexEntry* IndexBegin() const {
+    return reinterpret_cast<const internal::SceneIndexEntry*>(
+        index_.data() + kSceneLogHeaderSize);
+  }
+
+  internal::SceneIndexEntry IndexEntry(size_t idx) const {
+    internal::SceneIndexEntry entry;
+    std::memcpy(&entry, index_.data() + kSceneLogHeaderSize +
+                            idx * sizeof(entry), sizeof(entry));
+    return entry;
+  }
+
+  void SetName(uint32_t id, std::string_view name) {
+    if (id >= names_.size()) {
+      names_.resize(id + 1);
+      published_.resize(id + 1, false);
+    }
+    names_[id] = name;
+  }
+
+  /**
+   * Reads the records up to the time into the pending updates.
+   */
+  void ReadUntil(int64_t t) {
+    internal::SceneRecord record;
+    while (internal::ReadSceneRecord(log_.data(), log_.size(), cursor_,
+                                     &record) &&
+           record.t <= t) {
+      switch (record.type) {
+        case SceneRecordType::kKey:
+          SetName(record.id, record.payload);
+          break;
+        case SceneRecordType::kValue:
+          updates_[record.id] = record.payload;
+          break;
+        case SceneRecordType::kDelete:
+          updates_[record.id] = std::nullopt;
+          break;
+        default:
+          break;
+      }
+      cursor_ = record.offset_next;
+    }
+  }
+
+  /**
+   * Sends the pending updates with one MSET and one DEL.
+   */
+  void Publish(ctrl_utils::RedisClient& redis) {
+    if (updates_.empty()) return;
+    std::vector<std::string> command_set = {"MSET"};
+    std::vector<std::string> command_del = {"DEL"};
+    for (const auto& id_val : updates_) {
+      const uint32_t id = id_val.first;
+      if (id >= names_.size()) continue;
+      if (id_val.second) {
+        command_set.emplace_back(names_[id]);
+        command_set.emplace_back(*id_val.second);
+        published_[id] = true;
+      } else if (published_[id]) {
+        command_del.emplace_back(names_[id]);
+        published_[id] = false;
+      }
+    }
+    updates_.clear();
+
+    if (command_set.size() > 1) {
+      redis.send(command_set, [](cpp_redis::reply&) {});
+    }
+    if (command_del.size() > 1) {
+      redis.send(command_del, [](cpp_redis::reply&) {});
+    }
+    redis.commit();
+  }
+
+  void Join() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+  }
+
+  void Run(ctrl_utils::RedisClient& redis, double rate) {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1. / rate));
+    Clock::time_point t_last = Clock::now();
+    Clock::time_point t_next = t_last;
+    try {
+      while (running_) {
+        t_next += period;
+        std::this_thread::sleep_until(t_next);
+        const Clock::time_point t_now = Clock::now();
+        Step(redis, std::chrono::duration<double>(t_now - t_last).count());
+        t_last = t_now;
+      }
+    } catch (...) {
+      error_ = std::current_exception();
+      running_ = false;
+    }
+  }
+
+  internal::MappedFile log_;
+  internal::MappedFile index_;
+  size_t num_index_ = 0;
+  int64_t t_start_ = 0;
+  int64_t t_end_ = 0;
+
+  mutable std::mutex mtx_;
+  size_t cursor_ = 0;
+  int64_t t_ = 0;
+  double speed_ = 1.;
+  bool paused_ = false;
+
+  // Views into the log by key id.
+  std::vector<std::string_view> names_;
+  std::vector<bool> published_;
+  std::unordered_map<uint32_t, std::optional<std::string_view>> updates_;
+
+  std::atomic<bool> running_ = {false};
+  std::thread thread_;
+
+  // Error that stopped the background thread. Read after joining it.
+  std::exception_ptr error_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_SCENE_RECORDER_H_
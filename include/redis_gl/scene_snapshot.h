@@ -0,0 +1,397 @@
+/**
+ * scene_snapshot.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_SCENE_SNAPSHOT_H_
+#define REDIS_GL_SCENE_SNAPSHOT_H_
+
+#include "redis_gl/redis_gl.h"
+
+// std
+#include <algorithm>      // std::sort, std::unique
+#include <cstdint>        // uint8_t, uint64_t
+#include <future>         // std::future
+#include <iterator>       // std::distance
+#include <map>            // std::map
+#include <memory>         // std::make_shared, std::shared_ptr
+#include <mutex>          // std::lock_guard, std::mutex
+#include <string>         // std::string
+#include <string_view>    // std::string_view
+#include <unordered_map>  // std::unordered_map
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move, std::pair
+#include <vector>         // std::vector
+
+namespace redis_gl {
+
+namespace simulator {
+
+namespace internal {
+
+/**
+ * Whether a value is valid UTF-8. The server sends other values, such as the
+ * "\xff"-prefixed binary formats, as binary frames.
+ */
+inline bool IsUtf8(std::string_view str) {
+  for (size_t i = 0; i < str.size(); i++) {
+    const uint8_t c = static_cast<uint8_t>(str[i]);
+    size_t num_continuation;
+    if (c < 0x80) {
+      continue;
+    } else if ((c & 0xe0) == 0xc0 && c >= 0xc2) {
+      num_continuation = 1;
+    } else if ((c & 0xf0) == 0xe0) {
+      num_continuation = 2;
+    } else if ((c & 0xf8) == 0xf0 && c <= 0xf4) {
+      num_continuation = 3;
+    } else {
+      return false;
+    }
+    if (i + num_continuation >= str.size()) return false;
+    for (size_t j = 1; j <= num_continuation; j++) {
+      if ((static_cast<uint8_t>(str[i + j]) & 0xc0) != 0x80) return false;
+    }
+    i += num_continuation;
+  }
+  return true;
+}
+
+inline void AppendBigEndian(uint64_t value, size_t num_bytes,
+                            std::string* buffer) {
+  for (size_t i = num_bytes; i-- > 0;) {
+    buffer->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+/**
+ * Appends an unmasked, unfragmented WebSocket frame with the given opcode
+ * (0x1 text or 0x2 binary).
+ */
+inline void AppendWebSocketFrame(std::string_view payload, uint8_t opcode,
+                                 std::string* buffer) {
+  buffer->push_back(static_cast<char>(0x80 | opcode));
+  if (payload.size() < 126) {
+    buffer->push_back(static_cast<char>(payload.size()));
+  } else if (payload.size() <= 0xffff) {
+    buffer->push_back(static_cast<char>(126));
+    AppendBigEndian(payload.size(), 2, buffer);
+  } else {
+    buffer->push_back(static_cast<char>(127));
+    AppendBigEndian(payload.size(), 8, buffer);
+  }
+  buffer->append(payload.data(), payload.size());
+}
+
+/**
+ * Appends an unmasked, unfragmented WebSocket frame, as encoded by
+ * WebSocketServer.encode_bytes() in the Python server.
+ */
+inline void AppendWebSocketFrame(std::string_view payload,
+                                 std::string* buffer) {
+  AppendWebSocketFrame(payload, IsUtf8(payload) ? 0x1 : 0x2, buffer);
+}
+
+/**
+ * Appends an update message with the given updated and deleted keys:
+ *
+ *     uint32 (big endian) number of updates
+ *     [WebSocket frame of key, WebSocket frame of value] * updates
+ *     uint32 (big endian) number of deletes
+ *     [WebSocket frame of key] * deletes
+ */
+inline void AppendUpdateMessage(
+    const std::vector<std::pair<std::string_view, std::string_view>>& updates,
+    const std::vector<std::string_view>& deletes, std::string* buffer) {
+  AppendBigEndian(updates.size(), 4, buffer);
+  for (const std::pair<std::string_view, std::string_view>& key_val : updates) {
+    AppendWebSocketFrame(key_val.first, buffer);
+    AppendWebSocketFrame(key_val.second, buffer);
+  }
+  AppendBigEndian(deletes.size(), 4, buffer);
+  for (const std::string_view key : deletes) {
+    AppendWebSocketFrame(key, buffer);
+  }
+}
+
+/**
+ * Gets the values of existing keys with one MGET and waits for the reply.
+ */
+inline std::vector<std::pair<std::string, std::string>> MGet(
+    ctrl_utils::RedisClient& redis, const std::vector<std::string>& keys) {
+  std::vector<std::pair<std::string, std::string>> key_vals;
+  if (keys.empty()) return key_vals;
+
+  std::vector<std::string> command = {"MGET"};
+  command.insert(command.end(), keys.begin(), keys.end());
+  std::future<cpp_redis::reply> future = redis.send(command);
+  redis.commit();
+  const cpp_redis::reply reply = future.get();
+  if (!reply.is_array()) return key_vals;
+
+  const std::vector<cpp_redis::reply>& vals = reply.as_array();
+  for (size_t i = 0; i < vals.size() && i < keys.size(); i++) {
+    if (!vals[i].is_string()) continue;
+    key_vals.emplace_back(keys[i], vals[i].as_string());
+  }
+  return key_vals;
+}
+
+}  // namespace internal
+
+/**
+ * Keys of the models registered in a namespace.
+ */
+struct Scene {
+  // Values of the namespace arguments, the registered models and their
+  // descriptions, which change rarely.
+  std::vector<std::pair<std::string, std::string>> models;
+
+  // State keys the models refer to (any "key_*" field), which may change
+  // every frame.
+  std::vector<std::string> states;
+};
+
+/**
+ * Gets the models registered in a namespace and lists their state keys.
+ */
+inline Scene GetScene(ctrl_utils::RedisClient& redis,
+                      const ModelKeys& model_keys) {
+  std::vector<std::string> keys = {KEY_ARGS + "::" + model_keys.key_namespace};
+  const std::unordered_set<std::string> registry =
+      ListModelKeys(redis, model_keys, true).get();
+  keys.insert(keys.end(), registry.begin(), registry.end());
+
+  Scene scene;
+  scene.models = internal::MGet(redis, keys);
+
+  // Collect the keys referenced by the models
+  std::vector<std::string> keys_descriptions;
+  for (const std::pair<std::string, std::string>& key_val : scene.models) {
+    const nlohmann::json model =
+        nlohmann::json::parse(key_val.second, nullptr, false);
+    if (!model.is_object()) continue;
+    for (const auto& field : model.items()) {
+      if (!field.value().is_string()) continue;
+      const std::string& name = field.key();
+      const std::string value = field.value().get<std::string>();
+      if (value.empty()) continue;
+      if (name.compare(0, 4, "key_") == 0) {
+        scene.states.push_back(value);
+      } else if (name.size() > 5 &&
+                 name.compare(name.size() - 5, 5, "_hash") == 0) {
+        keys_descriptions.push_back(model_keys.key_descriptions_prefix + value);
+      }
+    }
+  }
+
+  // Models of the same type share a description
+  std::sort(keys_descriptions.begin(), keys_descriptions.end());
+  keys_descriptions.erase(
+      std::unique(keys_descriptions.begin(), keys_descriptions.end()),
+      keys_descriptions.end());
+  for (auto& key_val : internal::MGet(redis, keys_descriptions)) {
+    scene.models.push_back(std::move(key_val));
+  }
+  return scene;
+}
+
+/**
+ * Versioned snapshot of the keys shown by the viewer, for clients that join
+ * while others are already connected.
+ *
+ * Every update or deletion increments a generation counter. The snapshot
+ * keeps the encoded update message of all keys at some generation, so a
+ * joining client is sent that message plus a small delta of the keys changed
+ * since then, instead of a fresh read of every key in Redis. The snapshot is
+ * only re-encoded once the delta grows large, and connected clients are never
+ * affected by a join.
+ *
+ * Messages have the format of the Python server's update messages (see
+ * internal::AppendUpdateMessage()).
+ *
+ * server.py keeps an equivalent snapshot (python/SceneSnapshot.py).
+ *
+ * Example:
+ *
+ *     SceneSnapshot snapshot;
+ *     snapshot.Load(redis, model_keys);
+ *
+ *     // Broadcast thread, under the same lock as the client list
+ *     snapshot.Update(key, val);
+ *
+ *     // Join
+ *     for (const auto& message : snapshot.Join()) client.Send(*message);
+ */
+class SceneSnapshot {
+ public:
+  using Message = std::shared_ptr<const std::string>;
+
+  /**
+   * Sets the latest value of a key.
+   *
+   * @return Generation of the snapshot. Unchanged values do not increment it.
+   */
+  uint64_t Update(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = entries_.find(key);
+    if (it != entries_.end() && !it->second.deleted &&
+        it->second.value == value) {
+      return generation_;
+    }
+    if (it == entries_.end()) it = entries_.emplace(key, Entry()).first;
+    if (it->second.deleted) num_deleted_--;
+    Touch(it);
+    it->second.value = value;
+    it->second.deleted = false;
+    return generation_;
+  }
+
+  /**
+   * Deletes a key.
+   *
+   * @return Generation of the snapshot.
+   */
+  uint64_t Delete(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.deleted) return generation_;
+    Touch(it);
+    it->second.value.clear();
+    it->second.deleted = true;
+    num_deleted_++;
+    return generation_;
+  }
+
+  /**
+   * Returns the messages that bring a new client up to date: the encoded
+   * snapshot, followed by the delta since its generation if there is one.
+   *
+   * The snapshot message is shared between joins. It is re-encoded once the
+   * delta covers more than half of the keys.
+   *
+   * @param generation Optional output of the generation the client is at.
+   */
+  std::vector<Message> Join(uint64_t* generation = nullptr) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    const size_t num_delta = std::distance(
+        log_.upper_bound(generation_snapshot_), log_.end());
+    if (!snapshot_ || 2 * num_delta > entries_.size()) {
+      EncodeSnapshot();
+    }
+
+    std::vector<Message> messages = {snapshot_};
+    if (generation_snapshot_ < generation_) {
+      messages.push_back(std::make_shared<const std::string>(
+          Encode(log_.upper_bound(generation_snapshot_), false)));
+    }
+    if (generation != nullptr) *generation = generation_;
+    return messages;
+  }
+
+  /**
+   * Loads the scene of a namespace (see GetScene()) and the latest values of
+   * its state keys.
+   */
+  void Load(ctrl_utils::RedisClient& redis, const ModelKeys& model_keys) {
+    const Scene scene = GetScene(redis, model_keys);
+    for (const auto& key_val : scene.models) {
+      Update(key_val.first, key_val.second);
+    }
+    for (const auto& key_val : internal::MGet(redis, scene.states)) {
+      Update(key_val.first, key_val.second);
+    }
+  }
+
+  uint64_t generation() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return generation_;
+  }
+
+  /**
+   * Number of keys in the snapshot.
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return entries_.size() - num_deleted_;
+  }
+
+ private:
+  struct Entry {
+    std::string value;
+    uint64_t generation = 0;
+    bool deleted = false;
+  };
+  using EntryMap = std::unordered_map<std::string, Entry>;
+
+  /**
+   * Moves a key to the end of the log with a new generation.
+   */
+  void Touch(EntryMap::iterator it) {
+    Entry& entry = it->second;
+    if (entry.generation > 0) log_.erase(entry.generation);
+    entry.generation = ++generation_;
+    log_.emplace(entry.generation, &*it);
+  }
+
+  /**
+   * Encodes the entries of the log from the given position.
+   */
+  std::string Encode(
+      std::map<uint64_t, const EntryMap::value_type*>::const_iterator begin,
+      bool skip_deleted) const {
+    std::vector<std::pair<std::string_view, std::string_view>> updates;
+    std::vector<std::string_view> deletes;
+    for (auto it = begin; it != log_.end(); ++it) {
+      const EntryMap::value_type& key_val = *it->second;
+      if (!key_val.second.deleted) {
+        updates.emplace_back(key_val.first, key_val.second.value);
+      } else if (!skip_deleted) {
+        deletes.push_back(key_val.first);
+      }
+    }
+
+    std::string message;
+    internal::AppendUpdateMessage(updates, deletes, &message);
+    return message;
+  }
+
+  /**
+   * Encodes all keys and drops deleted keys, which no joining client needs
+   * anymore.
+   */
+  void EncodeSnapshot() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (!it->second.deleted) {
+        ++it;
+        continue;
+      }
+      log_.erase(it->second.generation);
+      it = entries_.erase(it);
+    }
+    num_deleted_ = 0;
+    snapshot_ = std::make_shared<const std::string>(Encode(log_.begin(), true));
+    generation_snapshot_ = generation_;
+  }
+
+  mutable std::mutex mtx_;
+  uint64_t generation_ = 0;
+  EntryMap entries_;
+  size_t num_deleted_ = 0;
+
+  // Latest generation of each key, in order of generation.
+  std::map<uint64_t, const EntryMap::value_type*> log_;
+
+  Message snapshot_;
+  uint64_t generation_snapshot_ = 0;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_SCENE_SNAPSHOT_H_
@@ -0,0 +1,120 @@
+/**
+ * state_key.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_STATE_KEY_H_
+#define REDIS_GL_STATE_KEY_H_
+
+#include "redis_gl/codec.h"
+#include "redis_gl/format.h"
+#include "redis_gl/redis_gl.h"
+
+// std
+#include <optional>  // std::optional
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Typed handle of a state key that is set every control tick.
+ *
+ * The key and its SET command are resolved once at construction. Each call to
+ * Set() formats the value in place into the value slot of the command with
+ * std::to_chars, so no std::stringstream is constructed, and once the slot has
+ * grown to the longest value, formatting does not allocate. The command is
+ * RESP-encoded by cpp_redis, which does not accept pre-encoded commands.
+ *
+ * Supported value types are Eigen vectors and matrices (e.g. Eigen::Vector3d
+ * or Eigen::VectorXd), Eigen::Quaterniond (xyzw order), and std::string.
+ *
+ * Constructed with a CodecPrecision, the key sets Eigen values in the
+ * quantized binary format of codec.h instead, which the viewer decodes
+ * without parsing text.
+ *
+ * Example:
+ *
+ *     StateKey<Eigen::VectorXd> key_q(robot.key_q);
+ *     StateKey<Eigen::Quaterniond> key_ori(object.key_ori, CodecPrecision());
+ *     while (true) {
+ *       key_q.Set(redis, ab.q());
+ *       key_ori.Set(redis, quat);
+ *       redis.commit();
+ *     }
+ */
+template <typename T>
+class StateKey {
+ public:
+  StateKey() = default;
+
+  explicit StateKey(const std::string& key) : command_({"SET", key, ""}) {}
+
+  StateKey(const std::string& key, const CodecPrecision& precision)
+      : StateKey(key) {
+    precision_ = precision;
+  }
+
+  const std::string& key() const { return command_[1]; }
+
+  /**
+   * Formats the value into the reusable buffer.
+   *
+   * @return Formatted value, valid until the next call.
+   */
+  const std::string& Format(const T& value) {
+    std::string& val = command_[2];
+    val.clear();
+    Append(value, &val);
+    return val;
+  }
+
+  /**
+   * Sends the SET command with the formatted value.
+   */
+  void Set(ctrl_utils::RedisClient& redis, const T& value,
+           bool commit = false) {
+    if (command_.empty()) return;
+    Format(value);
+    redis.send(command_, [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+  }
+
+ private:
+  template <typename Derived>
+  void Append(const Eigen::DenseBase<Derived>& value,
+              std::string* buffer) const {
+    if (precision_) {
+      EncodeVectors(value, *precision_, buffer);
+    } else {
+      internal::AppendMatrix(value, buffer);
+    }
+  }
+
+  void Append(const Eigen::Quaterniond& quat, std::string* buffer) const {
+    if (precision_) {
+      EncodeQuaternion(quat, *precision_, buffer);
+    } else {
+      internal::AppendMatrix(quat.coeffs(), buffer);
+    }
+  }
+
+  void Append(const std::string& value, std::string* buffer) const {
+    buffer->append(value);
+  }
+
+  std::vector<std::string> command_;
+  std::optional<CodecPrecision> precision_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_STATE_KEY_H_
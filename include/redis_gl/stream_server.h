@@ -0,0 +1,659 @@
+/**
+ * stream_server.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_STREAM_SERVER_H_
+#define REDIS_GL_STREAM_SERVER_H_
+
+#include "redis_gl/frame_publisher.h"
+#include "redis_gl/redis_gl.h"
+#include "redis_gl/scene_snapshot.h"
+
+// std
+#include <array>          // std::array
+#include <atomic>         // std::atomic
+#include <cctype>         // std::tolower
+#include <cerrno>         // errno, EAGAIN, EINTR, EWOULDBLOCK
+#include <cstdint>        // uint8_t, uint32_t, uint64_t
+#include <cstring>        // std::strerror
+#include <memory>         // std::unique_ptr
+#include <mutex>          // std::lock_guard, std::mutex
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string
+#include <string_view>    // std::string_view
+#include <thread>         // std::thread
+#include <unordered_map>  // std::unordered_map
+#include <utility>        // std::move, std::pair
+#include <vector>         // std::vector
+
+// posix
+#include <fcntl.h>        // ::fcntl
+#include <netinet/in.h>   // sockaddr_in
+#include <netinet/tcp.h>  // TCP_NODELAY
+#include <poll.h>         // ::poll
+#include <sys/socket.h>   // ::socket, ::bind, ::listen, ::accept, ::send
+#include <unistd.h>       // ::close, ::pipe, ::read, ::write
+
+namespace redis_gl {
+
+namespace simulator {
+
+namespace internal {
+
+/**
+ * Computes the SHA-1 digest used by the WebSocket handshake.
+ */
+inline std::array<uint8_t, 20> Sha1(std::string_view message) {
+  uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+                   0xc3d2e1f0};
+  const auto rotl = [](uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+  };
+
+  // Pad with 0x80, zeros and the message length in bits
+  std::string data(message);
+  data.push_back(static_cast<char>(0x80));
+  while (data.size() % 64 != 56) data.push_back('\0');
+  AppendBigEndian(8 * static_cast<uint64_t>(message.size()), 8, &data);
+
+  for (size_t idx = 0; idx < data.size(); idx += 64) {
+    uint32_t w[80];
+    for (size_t i = 0; i < 16; i++) {
+      const uint8_t* b = reinterpret_cast<const uint8_t*>(&data[idx + 4 * i]);
+      w[i] = (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) |
+             (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+    }
+    for (size_t i = 16; i < 80; i++) {
+      w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (size_t i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5a827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ed9eba1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8f1bbcdc;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xca62c1d6;
+      }
+      const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  std::array<uint8_t, 20> digest;
+  for (size_t i = 0; i < 20; i++) {
+    digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+  }
+  return digest;
+}
+
+inline std::string Base64(const uint8_t* data, size_t size) {
+  static constexpr char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string str;
+  for (size_t i = 0; i < size; i += 3) {
+    const uint32_t n = (uint32_t(data[i]) << 16) |
+                       (i + 1 < size ? uint32_t(data[i + 1]) << 8 : 0) |
+                       (i + 2 < size ? uint32_t(data[i + 2]) : 0);
+    str.push_back(kChars[(n >> 18) & 0x3f]);
+    str.push_back(kChars[(n >> 12) & 0x3f]);
+    str.push_back(i + 1 < size ? kChars[(n >> 6) & 0x3f] : '=');
+    str.push_back(i + 2 < size ? kChars[n & 0x3f] : '=');
+  }
+  return str;
+}
+
+/**
+ * Returns the Sec-WebSocket-Key header of an HTTP upgrade request, or an
+ * empty string if there is none.
+ */
+inline std::string ParseWebSocketKey(std::string_view request) {
+  static constexpr std::string_view kHeader = "sec-websocket-key:";
+  size_t idx_line = 0;
+  while (idx_line < request.size()) {
+    size_t idx_end = request.find("\r\n", idx_line);
+    if (idx_end == std::string_view::npos) idx_end = request.size();
+    const std::string_view line = request.substr(idx_line, idx_end - idx_line);
+    idx_line = idx_end + 2;
+    if (line.size() <= kHeader.size()) continue;
+
+    bool is_key = true;
+    for (size_t i = 0; i < kHeader.size() && is_key; i++) {
+      is_key = std::tolower(static_cast<unsigned char>(line[i])) == kHeader[i];
+    }
+    if (!is_key) continue;
+
+    std::string_view key = line.substr(kHeader.size());
+    while (!key.empty() && key.front() == ' ') key.remove_prefix(1);
+    while (!key.empty() && key.back() == ' ') key.remove_suffix(1);
+    return std::string(key);
+  }
+  return "";
+}
+
+}  // namespace internal
+
+/**
+ * WebSocket server embedded in the controller process, which streams state to
+ * the viewer without Redis polling or the Python server.
+ *
+ * The server runs its own poll() event loop on a background thread. It keeps
+ * a SceneSnapshot for joining clients, and sends every value passed to
+ * Publish() to the connected clients in the update message format that
+ * simulator.js parses.
+ *
+ * Publish() never blocks on the network. Each client has a queue of pending
+ * values with at most one entry per key, so a newer value replaces the stale
+ * one still waiting to be sent. While a slow client is still receiving its
+ * previous message, its pending values accumulate. When that message is sent,
+ * they go out together as the next message. A batch passed to one Publish()
+ * call always arrives in one message.
+ *
+ * Models are still registered in Redis. Load() reads them from there, and
+ * only state values bypass Redis. Open the viewer with `?ws_port=<port>` to
+ * connect to this server instead of the Python server.
+ *
+ * Example:
+ *
+ *     StreamServer server(8002);
+ *     server.Load(redis, model_keys);
+ *     server.Start();
+ *
+ *     FramePublisher publisher(model_keys);
+ *     while (true) {
+ *       publisher.SetRobot(robot);
+ *       publisher.Publish(server);
+ *     }
+ */
+class StreamServer {
+ public:
+  /**
+   * @param port Port of the WebSocket server, or 0 to pick any free port.
+   */
+  explicit StreamServer(int port = 8002) : port_(port) {}
+
+  ~StreamServer() { Stop(); }
+
+  StreamServer(const StreamServer&) = delete;
+  StreamServer& operator=(const StreamServer&) = delete;
+
+  /**
+   * Listens on the port and starts the event loop.
+   *
+   * @throws std::runtime_error if the port cannot be opened.
+   */
+  void Start() {
+    if (running_) return;
+
+    fd_listen_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_listen_ < 0) ThrowErrno("socket()");
+    const int enable = 1;
+    ::setsockopt(fd_listen_, SOL_SOCKET, SO_REUSEADDR, &enable,
+                 sizeof(enable));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port_));
+    const sockaddr* addr_listen = reinterpret_cast<sockaddr*>(&addr);
+    if (::bind(fd_listen_, addr_listen, sizeof(addr)) < 0 ||
+        ::listen(fd_listen_, 16) < 0) {
+      const int err = errno;
+      ::close(fd_listen_);
+      fd_listen_ = -1;
+      errno = err;
+      ThrowErrno("bind()");
+    }
+    socklen_t len_addr = sizeof(addr);
+    ::getsockname(fd_listen_, reinterpret_cast<sockaddr*>(&addr), &len_addr);
+    port_ = ntohs(addr.sin_port);
+
+    int fd_wake[2];
+    if (::pipe(fd_wake) < 0) ThrowErrno("pipe()");
+    SetNonBlocking(fd_listen_);
+    SetNonBlocking(fd_wake[0]);
+    SetNonBlocking(fd_wake[1]);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      fd_wake_[0] = fd_wake[0];
+      fd_wake_[1] = fd_wake[1];
+    }
+
+    running_ = true;
+    wake_pending_ = false;
+    thread_ = std::thread(&StreamServer::Run, this);
+  }
+
+  /**
+   * Stops the event loop and disconnects all clients.
+   */
+  void Stop() {
+    if (!running_) return;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      running_ = false;
+      Wake(true);
+    }
+    thread_.join();
+
+    // Publish() may still be called from other threads
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const std::unique_ptr<Client>& client : clients_) {
+      ::close(client->fd);
+    }
+    clients_.clear();
+    ::close(fd_listen_);
+    ::close(fd_wake_[0]);
+    ::close(fd_wake_[1]);
+    fd_listen_ = -1;
+    fd_wake_[0] = -1;
+    fd_wake_[1] = -1;
+  }
+
+  /**
+   * Loads the models of a namespace and the latest values of their state keys
+   * from Redis, and sends them to the connected clients. Call again after
+   * registering new models.
+   */
+  void Load(ctrl_utils::RedisClient& redis, const ModelKeys& model_keys) {
+    const Scene scene = GetScene(redis, model_keys);
+    std::vector<std::pair<std::string, std::string>> key_vals = scene.models;
+    for (auto& key_val : internal::MGet(redis, scene.states)) {
+      key_vals.push_back(std::move(key_val));
+    }
+    Publish(key_vals);
+  }
+
+  /**
+   * Sends a value to all clients.
+   */
+  void Publish(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stage(key, value, false);
+    Wake();
+  }
+
+  /**
+   * Sends a batch of values to all clients in one message.
+   */
+  void Publish(const std::vector<std::pair<std::string, std::string>>&
+                   key_vals) {
+    if (key_vals.empty()) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const std::pair<std::string, std::string>& key_val : key_vals) {
+      Stage(key_val.first, key_val.second, false);
+    }
+    Wake();
+  }
+
+  /**
+   * Sends the values staged in a frame publisher to all clients in one
+   * message, instead of setting them in Redis.
+   *
+   * @return Id of the published frame, or 0 if nothing was staged.
+   */
+  uint64_t Publish(FramePublisher& publisher) {
+    std::vector<std::pair<std::string, std::string>> key_vals;
+    const uint64_t frame_id = publisher.TakeFrame(&key_vals);
+    Publish(key_vals);
+    return frame_id;
+  }
+
+  /**
+   * Deletes a key from all clients.
+   */
+  void Delete(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Stage(key, "", true);
+    Wake();
+  }
+
+  /**
+   * Port of the server, resolved by Start() if it was 0.
+   */
+  int port() const { return port_; }
+
+  /**
+   * Number of clients that completed the WebSocket handshake.
+   */
+  size_t num_clients() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t num_clients = 0;
+    for (const std::unique_ptr<Client>& client : clients_) {
+      num_clients += client->open;
+    }
+    return num_clients;
+  }
+
+  const SceneSnapshot& snapshot() const { return snapshot_; }
+
+ private:
+  // Largest request or client message held before the client is dropped.
+  static constexpr size_t kMaxNumBytesIn = 1 << 20;
+
+  struct Pending {
+    std::string value;
+    bool deleted = false;
+  };
+
+  struct Client {
+    int fd = -1;
+
+    // Whether the handshake completed. Set by the event loop under mtx_.
+    bool open = false;
+
+    // Latest values not yet sent, at most one per key. Guarded by mtx_.
+    std::vector<std::pair<std::string, Pending>> pending;
+    std::unordered_map<std::string, size_t> idx_pending;
+
+    // Only used by the event loop.
+    std::string in;
+    std::string out;
+    size_t idx_out = 0;
+    bool closing = false;
+  };
+
+  [[noreturn]] static void ThrowErrno(const std::string& function) {
+    throw std::runtime_error("StreamServer: " + function + " failed: " +
+                             std::strerror(errno));
+  }
+
+  static void SetNonBlocking(int fd) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  }
+
+  /**
+   * Updates the snapshot and the pending values of every open client.
+   * Requires mtx_.
+   */
+  void Stage(const std::string& key, const std::string& value, bool deleted) {
+    if (deleted) {
+      snapshot_.Delete(key);
+    } else {
+      snapshot_.Update(key, value);
+    }
+    for (const std::unique_ptr<Client>& client : clients_) {
+      if (!client->open) continue;
+      auto it = client->idx_pending.find(key);
+      if (it == client->idx_pending.end()) {
+        client->idx_pending.emplace(key, client->pending.size());
+        client->pending.emplace_back(key, Pending{value, deleted});
+      } else {
+        Pending& pending = client->pending[it->second].second;
+        pending.value = value;
+        pending.deleted = deleted;
+      }
+    }
+  }
+
+  /**
+   * Wakes up the event loop, unless a wake-up is already pending.
+   *
+   * Requires mtx_, since Stop() closes the pipe.
+   */
+  void Wake(bool force = false) {
+    if (fd_wake_[1] < 0) return;
+    if (wake_pending_.exchange(true) && !force) return;
+    const char c = 0;
+    const ssize_t result = ::write(fd_wake_[1], &c, 1);
+    static_cast<void>(result);
+  }
+
+  void Run() {
+    std::vector<pollfd> fds;
+    while (running_) {
+      fds.clear();
+      fds.push_back({fd_listen_, POLLIN, 0});
+      fds.push_back({fd_wake_[0], POLLIN, 0});
+      for (const std::unique_ptr<Client>& client : clients_) {
+        const bool has_out = client->idx_out < client->out.size();
+        fds.push_back({client->fd,
+                       static_cast<short>(POLLIN | (has_out ? POLLOUT : 0)),
+                       0});
+      }
+      if (::poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) break;
+
+      if (fds[1].revents & POLLIN) {
+        char buffer[64];
+        while (::read(fd_wake_[0], buffer, sizeof(buffer)) > 0) {
+        }
+        wake_pending_ = false;
+      }
+
+      for (size_t i = 0; i < clients_.size(); i++) {
+        if (fds[i + 2].revents & (POLLIN | POLLERR | POLLHUP)) {
+          Receive(*clients_[i]);
+        }
+      }
+      if (fds[0].revents & POLLIN) Accept();
+
+      for (const std::unique_ptr<Client>& client : clients_) {
+        if (!client->closing) Send(*client);
+      }
+      RemoveClosed();
+    }
+  }
+
+  void Accept() {
+    while (true) {
+      const int fd = ::accept(fd_listen_, nullptr, nullptr);
+      if (fd < 0) return;
+      SetNonBlocking(fd);
+      const int enable = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+      std::unique_ptr<Client> client = std::make_unique<Client>();
+      client->fd = fd;
+      std::lock_guard<std::mutex> lock(mtx_);
+      clients_.push_back(std::move(client));
+    }
+  }
+
+  void Receive(Client& client) {
+    char buffer[4096];
+    while (true) {
+      const ssize_t num_bytes = ::recv(client.fd, buffer, sizeof(buffer), 0);
+      if (num_bytes > 0 && client.in.size() + num_bytes <= kMaxNumBytesIn) {
+        client.in.append(buffer, num_bytes);
+        continue;
+      }
+      if (num_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      if (num_bytes < 0 && errno == EINTR) continue;
+      client.closing = true;
+      return;
+    }
+
+    if (!client.open) {
+      Handshake(client);
+    } else {
+      ParseFrames(client);
+    }
+  }
+
+  /**
+   * Accepts the upgrade request and sends the snapshot in the same step as
+   * opening the client, so it receives every value published afterwards.
+   */
+  void Handshake(Client& client) {
+    const size_t idx_end = client.in.find("\r\n\r\n");
+    if (idx_end == std::string::npos) return;
+
+    const std::string key = internal::ParseWebSocketKey(
+        std::string_view(client.in).substr(0, idx_end));
+    if (key.empty()) {
+      client.out = "HTTP/1.1 400 Bad Request\r\n\r\n";
+      Send(client);
+      client.closing = true;
+      return;
+    }
+    client.in.erase(0, idx_end + 4);
+
+    const std::array<uint8_t, 20> digest =
+        internal::Sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    client.out =
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: " +
+        internal::Base64(digest.data(), digest.size()) + "\r\n\r\n";
+
+    std::string message;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (const SceneSnapshot::Message& payload : snapshot_.Join()) {
+        message.append(*payload);
+      }
+      client.open = true;
+    }
+    internal::AppendWebSocketFrame(message, 0x2, &client.out);
+  }
+
+  /**
+   * Discards the client's messages (e.g. latency reports) and closes the
+   * connection on a close frame.
+   */
+  void ParseFrames(Client& client) {
+    size_t idx = 0;
+    while (client.in.size() - idx >= 2) {
+      const uint8_t* data = reinterpret_cast<const uint8_t*>(&client.in[idx]);
+      const uint8_t opcode = data[0] & 0x0f;
+      uint64_t len_payload = data[1] & 0x7f;
+      const size_t num_bytes_len =
+          len_payload == 126 ? 2 : len_payload == 127 ? 8 : 0;
+      const size_t num_bytes_mask = (data[1] & 0x80) ? 4 : 0;
+      const size_t len_header = 2 + num_bytes_len + num_bytes_mask;
+      if (client.in.size() - idx < len_header) break;
+      if (num_bytes_len > 0) {
+        len_payload = 0;
+        for (size_t i = 0; i < num_bytes_len; i++) {
+          len_payload = (len_payload << 8) | data[2 + i];
+        }
+      }
+      if (client.in.size() - idx < len_header + len_payload) break;
+      idx += len_header + len_payload;
+
+      if (opcode == 0x8) {
+        client.closing = true;
+        return;
+      }
+    }
+    client.in.erase(0, idx);
+  }
+
+  /**
+   * Writes as much of the outgoing buffer as the socket accepts. Once it is
+   * empty, the client's pending values become the next message.
+   */
+  void Send(Client& client) {
+    while (true) {
+      if (client.idx_out == client.out.size()) {
+        client.out.clear();
+        client.idx_out = 0;
+        if (!client.open || !TakePending(client)) return;
+      }
+
+      const ssize_t num_bytes =
+          ::send(client.fd, client.out.data() + client.idx_out,
+                 client.out.size() - client.idx_out, kSendFlags);
+      if (num_bytes > 0) {
+        client.idx_out += num_bytes;
+        continue;
+      }
+      if (num_bytes < 0 && errno == EINTR) continue;
+      if (num_bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      client.closing = true;
+      return;
+    }
+  }
+
+  /**
+   * Encodes the pending values of the client as its next message.
+   *
+   * @return Whether there were any pending values.
+   */
+  bool TakePending(Client& client) {
+    std::vector<std::pair<std::string, Pending>> pending;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      pending.swap(client.pending);
+      client.idx_pending.clear();
+    }
+    if (pending.empty()) return false;
+    EncodeMessage(pending, &client.out);
+    return true;
+  }
+
+  static void EncodeMessage(
+      const std::vector<std::pair<std::string, Pending>>& pending,
+      std::string* out) {
+    std::vector<std::pair<std::string_view, std::string_view>> updates;
+    std::vector<std::string_view> deletes;
+    for (const std::pair<std::string, Pending>& key_val : pending) {
+      if (key_val.second.deleted) {
+        deletes.push_back(key_val.first);
+      } else {
+        updates.emplace_back(key_val.first, key_val.second.value);
+      }
+    }
+    std::string message;
+    internal::AppendUpdateMessage(updates, deletes, &message);
+    internal::AppendWebSocketFrame(message, 0x2, out);
+  }
+
+  void RemoveClosed() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto it = clients_.begin(); it != clients_.end();) {
+      if (!(*it)->closing) {
+        ++it;
+        continue;
+      }
+      ::close((*it)->fd);
+      it = clients_.erase(it);
+    }
+  }
+
+#ifdef MSG_NOSIGNAL
+  static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+  static constexpr int kSendFlags = 0;
+#endif
+
+  int port_;
+  int fd_listen_ = -1;
+  int fd_wake_[2] = {-1, -1};
+  std::atomic<bool> running_ = {false};
+  std::atomic<bool> wake_pending_ = {false};
+  std::thread thread_;
+
+  mutable std::mutex mtx_;
+  std::vector<std::unique_ptr<Client>> clients_;
+  SceneSnapshot snapshot_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_STREAM_SERVER_H_
@@ -0,0 +1,287 @@
+/**
+ * trajectory.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_TRAJECTORY_H_
+#define REDIS_GL_TRAJECTORY_H_
+
+#include "redis_gl/redis_gl.h"
+
+// std
+#include <algorithm>  // std::max, std::min
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstring>    // std::memcpy
+#include <string>     // std::string
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+namespace redis_gl {
+
+namespace simulator {
+
+/**
+ * Packed trajectory format published by TrajectoryPublisher.
+ *
+ * The buffer starts with a 24-byte little-endian header:
+ *
+ *     0  uint8[4] magic "\xffRGT"
+ *     4  uint8    version
+ *     5  uint8    flags (kTrajectoryProvisionalHead)
+ *     6  uint8[2] reserved
+ *     8  uint32   number of vertices N
+ *     12 uint32   reserved
+ *     16 uint64   base sequence number
+ *
+ * followed by N float32 xyz positions and N uint32 sequence numbers relative
+ * to the base sequence number, both in increasing order. If the provisional
+ * head flag is set, the last vertex is the newest sample, which may still be
+ * removed by the simplification, and should be drawn but not stored.
+ */
+constexpr char kTrajectoryMagic[4] = {'\xff', 'R', 'G', 'T'};
+constexpr uint8_t kTrajectoryVersion = 1;
+constexpr uint8_t kTrajectoryProvisionalHead = 1;
+constexpr size_t kTrajectoryHeaderSize = 24;
+
+/**
+ * Records a high-rate trajectory and publishes it as a simplified polyline
+ * to `TrajectoryModel::key_samples`.
+ *
+ * Append() stores every sample in a fixed-capacity ring buffer without
+ * allocating. Publish() simplifies the samples since the last final vertex
+ * with the Ramer-Douglas-Peucker algorithm, so that every sample lies within
+ * `tolerance` of the polyline. Vertices before the newest sample are final
+ * and move to a ring of vertices, while the samples after them stay pending
+ * so that a straight segment spanning several publishes still becomes one
+ * line.
+ *
+ * Each publish sends the last `num_vertices_window` final vertices, tagged
+ * with the sequence number of the sample they came from, plus the newest
+ * sample as a provisional head. The viewer appends only vertices newer than
+ * the last one it has seen, so no samples are lost as long as it polls at
+ * least once every `num_vertices_window` vertices, and the size of each
+ * message stays bounded.
+ *
+ * Append() and Publish() must be called from the same thread.
+ *
+ * Example:
+ *
+ *     TrajectoryPublisher publisher(trajectory);
+ *     while (true) {
+ *       publisher.Append(ee_pos);  // 1 kHz
+ *       if (tick % 10 == 0) publisher.Publish(redis, true);
+ *     }
+ */
+class TrajectoryPublisher {
+ public:
+  /**
+   * @param trajectory Trajectory model with a non-empty key_samples.
+   * @param capacity Maximum number of samples between publishes.
+   * @param tolerance Maximum distance of a sample to the simplified polyline.
+   * @param num_vertices_window Number of vertices sent per publish.
+   */
+  explicit TrajectoryPublisher(const TrajectoryModel& trajectory,
+                               size_t capacity = 4096,
+                               double tolerance = 0.001,
+                               size_t num_vertices_window = 256)
+      : key_samples_(trajectory.key_samples),
+        tolerance_(tolerance),
+        samples_(std::max(capacity, size_t{4})),
+        vertices_(std::max(num_vertices_window, size_t{2})) {
+    pending_.reserve(samples_.size() + 1);
+    keep_.reserve(samples_.size() + 1);
+    stack_.reserve(samples_.size() + 1);
+  }
+
+  /**
+   * Appends a sample to the ring buffer.
+   *
+   * If more than `capacity` samples are appended between publishes, the
+   * oldest ones are overwritten and counted in num_dropped().
+   */
+  void Append(const Eigen::Vector3d& pos) {
+    samples_[num_samples_ % samples_.size()] = pos.cast<float>();
+    num_samples_++;
+  }
+
+  /**
+   * Simplifies the new samples and publishes the latest vertices.
+   *
+   * @param redis Redis client.
+   * @param commit Commit the set command (asynchronously).
+   * @return True if a message was sent.
+   */
+  bool Publish(ctrl_utils::RedisClient& redis, bool commit = false) {
+    if (num_samples_ == seq_published_) return false;
+    seq_published_ = num_samples_;
+    Simplify();
+
+    // Collect the final vertices in the window plus the provisional head
+    const uint64_t num_window =
+        std::min<uint64_t>(vertices_.size(), num_vertices_);
+    const uint64_t idx_begin = num_vertices_ - num_window;
+    const bool has_head = !has_anchor_ || head_.second != anchor_.second;
+    const uint32_t num = static_cast<uint32_t>(num_window + has_head);
+    const uint64_t base_seq =
+        num_window > 0 ? vertices_[idx_begin % vertices_.size()].second
+                       : head_.second;
+
+    buffer_.resize(kTrajectoryHeaderSize + num * 4 * sizeof(float));
+    char* header = &buffer_[0];
+    std::memset(header, 0, kTrajectoryHeaderSize);
+    std::memcpy(header, kTrajectoryMagic, sizeof(kTrajectoryMagic));
+    header[4] = static_cast<char>(kTrajectoryVersion);
+    header[5] = static_cast<char>(has_head ? kTrajectoryProvisionalHead : 0);
+    std::memcpy(header + 8, &num, sizeof(num));
+    std::memcpy(header + 16, &base_seq, sizeof(base_seq));
+
+    char* xyz = header + kTrajectoryHeaderSize;
+    char* seq = xyz + num * 3 * sizeof(float);
+    for (uint32_t i = 0; i < num; i++) {
+      const Vertex& vertex = i < num_window
+                                 ? vertices_[(idx_begin + i) % vertices_.size()]
+                                 : head_;
+      const uint32_t seq_offset =
+          static_cast<uint32_t>(vertex.second - base_seq);
+      std::memcpy(xyz + 3 * sizeof(float) * i, vertex.first.data(),
+                  3 * sizeof(float));
+      std::memcpy(seq + sizeof(uint32_t) * i, &seq_offset, sizeof(uint32_t));
+    }
+
+    redis.send({"SET", key_samples_, buffer_}, [](cpp_redis::reply&) {});
+    if (commit) redis.commit();
+    return true;
+  }
+
+  /**
+   * Sequence number of the next sample.
+   */
+  uint64_t sequence() const { return num_samples_; }
+
+  /**
+   * Number of samples overwritten before they were simplified.
+   */
+  uint64_t num_dropped() const { return num_dropped_; }
+
+  /**
+   * Total number of final vertices.
+   */
+  uint64_t num_vertices() const { return num_vertices_; }
+
+ private:
+  using Vertex = std::pair<Eigen::Vector3f, uint64_t>;
+
+  /**
+   * Runs Ramer-Douglas-Peucker on the pending samples and moves the kept
+   * samples before the newest one to the vertex ring.
+   */
+  void Simplify() {
+    // Skip samples that have been overwritten
+    const uint64_t seq_oldest =
+        num_samples_ > samples_.size() ? num_samples_ - samples_.size() : 0;
+    if (seq_next_ < seq_oldest) {
+      num_dropped_ += seq_oldest - seq_next_;
+      seq_next_ = seq_oldest;
+      has_anchor_ = false;
+    }
+
+    // Start from the last final vertex so that consecutive publishes join
+    // without exceeding the tolerance
+    pending_.clear();
+    if (has_anchor_) pending_.push_back(anchor_);
+    for (uint64_t seq = seq_next_; seq < num_samples_; seq++) {
+      pending_.push_back({samples_[seq % samples_.size()], seq});
+    }
+    head_ = pending_.back();
+
+    keep_.assign(pending_.size(), false);
+    keep_.front() = true;
+    keep_.back() = true;
+    stack_.clear();
+    if (pending_.size() > 2) stack_.push_back({0, pending_.size() - 1});
+    const float tolerance_sq = static_cast<float>(tolerance_ * tolerance_);
+    while (!stack_.empty()) {
+      const std::pair<size_t, size_t> segment = stack_.back();
+      stack_.pop_back();
+
+      // Find the sample farthest from the segment
+      const Eigen::Vector3f& a = pending_[segment.first].first;
+      const Eigen::Vector3f ab = pending_[segment.second].first - a;
+      const float ab_sq = ab.squaredNorm();
+      float dist_max = -1.f;
+      size_t idx_max = segment.first;
+      for (size_t i = segment.first + 1; i < segment.second; i++) {
+        const Eigen::Vector3f ap = pending_[i].first - a;
+        const float t =
+            ab_sq > 0.f ? std::min(1.f, std::max(0.f, ap.dot(ab) / ab_sq))
+                        : 0.f;
+        const float dist = (ap - t * ab).squaredNorm();
+        if (dist > dist_max) {
+          dist_max = dist;
+          idx_max = i;
+        }
+      }
+      if (dist_max <= tolerance_sq) continue;
+
+      keep_[idx_max] = true;
+      if (idx_max - segment.first > 1) {
+        stack_.push_back({segment.first, idx_max});
+      }
+      if (segment.second - idx_max > 1) {
+        stack_.push_back({idx_max, segment.second});
+      }
+    }
+
+    // Keep the newest sample pending, unless the pending samples would soon
+    // be overwritten
+    if (pending_.size() < 2) return;
+    size_t idx_end = pending_.size() - 1;
+    size_t idx_last = idx_end - 1;
+    while (idx_last > 0 && !keep_[idx_last]) idx_last--;
+    if (idx_end - idx_last > samples_.size() / 2) idx_end++;
+
+    // The anchor is already final
+    for (size_t i = has_anchor_ ? 1 : 0; i < idx_end; i++) {
+      if (!keep_[i]) continue;
+      vertices_[num_vertices_ % vertices_.size()] = pending_[i];
+      num_vertices_++;
+      anchor_ = pending_[i];
+      has_anchor_ = true;
+    }
+    if (has_anchor_) seq_next_ = anchor_.second + 1;
+  }
+
+  std::string key_samples_;
+  double tolerance_;
+
+  // Ring buffer of samples
+  std::vector<Eigen::Vector3f> samples_;
+  uint64_t num_samples_ = 0;
+  uint64_t seq_published_ = 0;
+  uint64_t num_dropped_ = 0;
+
+  // First sample after the last final vertex
+  uint64_t seq_next_ = 0;
+  Vertex anchor_ = {Eigen::Vector3f::Zero(), 0};
+  Vertex head_ = {Eigen::Vector3f::Zero(), 0};
+  bool has_anchor_ = false;
+
+  // Ring buffer of final vertices
+  std::vector<Vertex> vertices_;
+  uint64_t num_vertices_ = 0;
+
+  std::vector<Vertex> pending_;
+  std::vector<bool> keep_;
+  std::vector<std::pair<size_t, size_t>> stack_;
+  std::string buffer_;
+};
+
+}  // namespace simulator
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_TRAJECTORY_H_
@@ -0,0 +1,78 @@
+/**
+ * triple_buffer.h
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef REDIS_GL_TRIPLE_BUFFER_H_
+#define REDIS_GL_TRIPLE_BUFFER_H_
+
+// std
+#include <array>    // std::array
+#include <atomic>   // std::atomic
+#include <cstdint>  // uint8_t
+
+namespace redis_gl {
+
+/**
+ * Wait-free single-producer, single-consumer buffer holding the latest value.
+ *
+ * The writer fills back() and calls Publish(). The reader calls Update() to
+ * swap in the most recently published value and then reads front(). Neither
+ * side ever blocks, allocates, or observes a partially written value; the
+ * third buffer lets the writer keep writing while the reader holds the front.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  /**
+   * Writer: buffer to fill before calling Publish().
+   */
+  T& back() { return buffers_[idx_back_]; }
+
+  /**
+   * Writer: makes the back buffer available to the reader.
+   */
+  void Publish() {
+    const uint8_t state =
+        state_.exchange(idx_back_ | kDirty, std::memory_order_acq_rel);
+    idx_back_ = state & kIndexMask;
+  }
+
+  /**
+   * Reader: swaps in the latest published buffer.
+   *
+   * @return True if a new value was published since the last update.
+   */
+  bool Update() {
+    if (!(state_.load(std::memory_order_relaxed) & kDirty)) return false;
+    const uint8_t state =
+        state_.exchange(idx_front_, std::memory_order_acq_rel);
+    idx_front_ = state & kIndexMask;
+    return true;
+  }
+
+  /**
+   * Reader: latest value swapped in by Update().
+   */
+  const T& front() const { return buffers_[idx_front_]; }
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kDirty = 0x4;
+
+  std::array<T, 3> buffers_ = {};
+
+  // Index of the middle buffer and whether it holds an unread value.
+  alignas(64) std::atomic<uint8_t> state_ = {1};
+
+  alignas(64) uint8_t idx_back_ = 0;
+  alignas(64) uint8_t idx_front_ = 2;
+};
+
+}  // namespace redis_gl
+
+#endif  // REDIS_GL_TRIPLE_BUFFER_H_
@@ -10,6 +10,7 @@ import cgi
 import sys
 import os
 import mimetypes
+import shutil
 
 if sys.version_info >= (3,2):
     from urllib.parse import parse_qs
@@ -26,6 +27,8 @@ def makeHTTPRequestHandler(get_callback=None, post_callback=None, callback_args=
     """
     Factory method to create HTTPRequestHandler class with custom GET and POST callbacks.
 
+    The GET callback sends the whole response, e.g. with send_file().
+
     Usage:
 
     extra_args = {"random_num": 123}
@@ -33,8 +36,8 @@ def makeHTTPRequestHandler(get_callback=None, post_callback=None, callback_args=
     http_server.serve_forever()
 
     def handle_get_request(http_request_handler, get_vars, **kwargs):
-        with open("index.html","rb") as f:
-            http_request_handler.wfile.write(f.read())
+        if not http_request_handler.send_file("index.html"):
+            http_request_handler.send_error(404, "File not found.")
 
     def handle_post_request(http_request_handler, post_vars, **kwargs):
         for key, val in post_vars.items():
@@ -58,7 +61,7 @@ def makeHTTPRequestHandler(get_callback=None, post_callback=None, callback_args=
             """
             Guess the mime type of a file.
             """
-            base, ext = os.path.splitext(path)
+            base, ext = os.path.splitext(path.split("?", 1)[0])  # Ignore url parameters
             if ext in self.extensions_map:
                 return self.extensions_map[ext]
             ext = ext.lower()
@@ -74,6 +77,59 @@ def makeHTTPRequestHandler(get_callback=None, post_callback=None, callback_args=
             self.send_header("Content-type", self.guess_type(self.path))
             self.end_headers()
 
+        def send_file(self, path, path_gz=None):
+            """
+            Send a file with an ETag, or 304 Not Modified if it matches the
+            request's If-None-Match. The gzipped variant path_gz is sent instead
+            if the client accepts gzip. The body is sent with sendfile() where
+            available, so it is copied by the kernel without passing through
+            Python. Return False if the file cannot be opened.
+            """
+            content_encoding = None
+            f = None
+            if path_gz is not None and "gzip" in self.headers.get("Accept-Encoding", ""):
+                try:
+                    f = open(path_gz, "rb")
+                    content_encoding = "gzip"
+                except (IOError, OSError):
+                    pass
+            if f is None:
+                try:
+                    f = open(path, "rb")
+                except (IOError, OSError):
+                    return False
+
+            with f:
+                stat = os.fstat(f.fileno())
+                etag = '"%x-%x%s"' % (int(1e6 * stat.st_mtime), stat.st_size,
+                                      "-gzip" if content_encoding is not None else "")
+
+                etags = [tag.strip() for tag in self.headers.get("If-None-Match", "").split(",")]
+                if etag in etags or "*" in etags:
+                    self.send_response(304)
+                    self.send_header("ETag", etag)
+                    self.end_headers()
+                    return True
+
+                self.send_response(200)
+                self.send_header("Content-type", self.guess_type(path))
+                self.send_header("Content-Length", str(stat.st_size))
+                self.send_header("ETag", etag)
+                self.send_header("Cache-Control", "no-cache")  # Revalidate with the ETag
+                if path_gz is not None:
+                    self.send_header("Vary", "Accept-Encoding")
+                if content_encoding is not None:
+                    self.send_header("Content-Encoding", content_encoding)
+                self.end_headers()
+
+                if self.command == "HEAD":
+                    return True
+                if hasattr(self.connection, "sendfile"):
+                    self.connection.sendfile(f)
+                else:
+                    shutil.copyfileobj(f, self.wfile)
+            return True
+
         def do_HEAD(self):
             """
             Return HEAD request (same as GET but without any content).
@@ -84,11 +140,12 @@ def makeHTTPRequestHandler(get_callback=None, post_callback=None, callback_args=
             """
             Parse GET request and call get_callback(HTTPRequestHandler, get_vars, **callback_args).
             """
-            self.set_headers()
+            if get_callback is None:
+                self.set_headers()
+                return
 
             # Call get_callback argument
-            if get_callback is not None:
-                get_callback(self, None, **callback_args)
+            get_callback(self, None, **callback_args)
 
         def do_POST(self):
             """
@@ -0,0 +1,175 @@
+"""
+LatencyMonitor.py
+
+Author: Toki Migimatsu
+Created: October 2026
+"""
+
+from __future__ import print_function, division
+import collections
+import json
+import threading
+import time
+
+
+class LatencyMonitor:
+    """
+    Measure the latency of controller latency stamps through the server and
+    browser, and periodically write a report to Redis.
+
+    A stamp is the key "<namespace>::latency::stamp::<family>" with the value
+    "<sequence> <time>", where time is CLOCK_MONOTONIC in nanoseconds (see
+    include/redis_gl/latency.h). The report is written as JSON to
+    "<namespace>::latency":
+
+    {
+        "t": <monotonic time in ns>,
+        "families": {
+            <family>: {
+                <hop>: {"count", "dropped", "p50", "p99", "max"}
+            }
+        }
+    }
+
+    Hops are "redis" (stamp to read), "websocket" (read to send), "total"
+    (stamp to send), and "browser" (receive to render, measured by the
+    browser). Times are in milliseconds over the last max_samples samples, and
+    dropped counts sequence gaps since the server started.
+    """
+
+    INFIX_STAMP = "::latency::stamp::"
+    SUFFIX_REPORT = "::latency"
+
+    def __init__(self, redis_db, report_period=1.0, max_samples=1000):
+        self.redis_db = redis_db
+        self.report_period = report_period
+        self.max_samples = max_samples
+        self.lock = threading.Lock()
+
+        # (namespace, family) -> hop -> deque of latencies in ms
+        self.samples = {}
+        # (namespace, family) -> hop -> number of dropped stamps
+        self.dropped = {}
+        # key -> last sequence number read from Redis
+        self.seq_last = {}
+        # key -> (stamp time, read time) of reads not yet sent
+        self.pending = {}
+        self.t_report_last = time.monotonic_ns()
+
+    @classmethod
+    def parse_key(cls, key):
+        """
+        Return (namespace, family) of a stamp key, or None.
+        """
+        idx = key.find(cls.INFIX_STAMP)
+        if idx < 0:
+            return None
+        return key[:idx], key[idx+len(cls.INFIX_STAMP):]
+
+    def _record(self, id_family, hop, latency_ms=None, num_dropped=0):
+        if id_family not in self.samples:
+            self.samples[id_family] = {}
+            self.dropped[id_family] = {}
+        if hop not in self.samples[id_family]:
+            self.samples[id_family][hop] = collections.deque(maxlen=self.max_samples)
+            self.dropped[id_family][hop] = 0
+        if latency_ms is not None:
+            self.samples[id_family][hop].append(latency_ms)
+        self.dropped[id_family][hop] += num_dropped
+
+    def on_read(self, key, val, t_read=None):
+        """
+        Record the redis hop of a value read from Redis. Non-stamp keys are
+        ignored.
+        """
+        if t_read is None:
+            t_read = time.monotonic_ns()
+        if type(key) is bytes:
+            key = key.decode("utf-8")
+        id_family = self.parse_key(key)
+        if id_family is None:
+            return
+
+        try:
+            seq, t_stamp = (int(x) for x in val.split())
+        except (AttributeError, ValueError):
+            return
+
+        with self.lock:
+            seq_last = self.seq_last.get(key)
+            if seq_last is not None and seq == seq_last:
+                # Already recorded (e.g. resent to a new client)
+                return
+            # A smaller sequence number means the controller restarted
+            num_dropped = seq - seq_last - 1 if seq_last is not None and seq > seq_last else 0
+            self.seq_last[key] = seq
+            self.pending[key] = (t_stamp, t_read)
+            self._record(id_family, "redis", 1e-6 * (t_read - t_stamp), num_dropped)
+
+    def on_sent(self, keys, t_sent=None):
+        """
+        Record the websocket and total hops of keys sent to the clients.
+        """
+        if t_sent is None:
+            t_sent = time.monotonic_ns()
+        with self.lock:
+            for key in keys:
+                if type(key) is bytes:
+                    key = key.decode("utf-8")
+                if key not in self.pending:
+                    continue
+                t_stamp, t_read = self.pending.pop(key)
+                id_family = self.parse_key(key)
+                self._record(id_family, "websocket", 1e-6 * (t_sent - t_read))
+                self._record(id_family, "total", 1e-6 * (t_sent - t_stamp))
+
+    def on_browser_message(self, message):
+        """
+        Record a browser report of the form
+        {"latency": {<key>: {"samples": [<ms>], "dropped": <n>}}}.
+        Other messages are ignored.
+        """
+        try:
+            report = json.loads(bytes(message).decode("utf-8"))["latency"]
+        except (TypeError, ValueError, KeyError):
+            return
+
+        with self.lock:
+            for key, stats in report.items():
+                id_family = self.parse_key(key)
+                if id_family is None:
+                    continue
+                samples = stats.get("samples", [])
+                self._record(id_family, "browser", num_dropped=int(stats.get("dropped", 0)))
+                self.samples[id_family]["browser"].extend(float(x) for x in samples)
+
+    def maybe_report(self, t=None):
+        """
+        Write the reports to Redis if report_period has elapsed.
+        """
+        if t is None:
+            t = time.monotonic_ns()
+        if 1e-9 * (t - self.t_report_last) < self.report_period:
+            return
+        self.t_report_last = t
+
+        reports = {}
+        with self.lock:
+            for (namespace, family), hops in self.samples.items():
+                report = reports.setdefault(namespace, {"t": t, "families": {}})
+                stats_family = report["families"].setdefault(family, {})
+                for hop, samples in hops.items():
+                    stats_family[hop] = self._summarize(samples, self.dropped[(namespace, family)][hop])
+
+        for namespace, report in reports.items():
+            self.redis_db.set(namespace + LatencyMonitor.SUFFIX_REPORT, json.dumps(report))
+
+    @staticmethod
+    def _summarize(samples, num_dropped):
+        samples = sorted(samples)
+        stats = {"count": len(samples), "dropped": num_dropped, "p50": 0.0, "p99": 0.0, "max": 0.0}
+        if samples:
+            stats["p50"] = samples[int(0.5 * (len(samples) - 1))]
+            stats["p99"] = samples[int(0.99 * (len(samples) - 1))]
+            stats["max"] = samples[-1]
+        return stats
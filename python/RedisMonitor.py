@@ -1,7 +1,14 @@
+import collections
 import redis
+import threading
 import time
 import math
 
+from LatencyMonitor import LatencyMonitor
+from SceneSnapshot import SceneSnapshot
+from SubscriptionIndex import SubscriptionIndex
+from WebSocketServer import WebSocketServer
+
 class RedisMonitor:
     """
     Monitor Redis keys and send updates to all web socket clients.
@@ -23,6 +30,9 @@ class RedisMonitor:
 
         self.redis_db = redis.Redis(host=self.host, port=self.port, password=self.password, db=self.db, decode_responses=False)
         self.message_last = {}
+        self.latency_monitor = LatencyMonitor(self.redis_db)
+        self.snapshot = SceneSnapshot(WebSocketServer.encode_update)
+        self.subscriptions = SubscriptionIndex()
 
         if self.realtime:
             self.pubsub = self.redis_db.pubsub()
@@ -30,17 +40,22 @@ class RedisMonitor:
             self.message_buffer = []
 
             #  Need to perform the following command to enable keyevent notifications:
-            #  config set notify-keyspace-events "$E"
+            #  config set notify-keyspace-events "$gxE"
             notify_keyspace_events = self.redis_db.config_get("notify-keyspace-events")["notify-keyspace-events"]
-            if "$" not in notify_keyspace_events and "A" not in notify_keyspace_events:
-                # Add string commands to notifications
-                notify_keyspace_events += "$"
+            if "A" not in notify_keyspace_events:
+                # Add string commands, generic commands (del, unlink), and
+                # expirations to notifications
+                for event_class in "$gx":
+                    if event_class not in notify_keyspace_events:
+                        notify_keyspace_events += event_class
             if "E" not in notify_keyspace_events:
                 # Add keyevent events to notifications
                 notify_keyspace_events += "E"
             self.redis_db.config_set("notify-keyspace-events", notify_keyspace_events)
 
-            self.pubsub.psubscribe("__keyevent@%s__:set" % self.db)
+            # DEL and UNLINK both notify "del"
+            self.pubsub.psubscribe(*["__keyevent@%s__:%s" % (self.db, event)
+                                     for event in ("set", "del", "expired", "evicted")])
 
     def messenger(self, ws_server):
         """
@@ -50,20 +65,29 @@ class RedisMonitor:
 
         while True:
             time.sleep(self.refresh_rate)
+            self.latency_monitor.maybe_report()
 
             self.lock.acquire()
             if not self.message_buffer:
                 self.lock.release()
                 continue
 
-            keyvals = self.message_buffer
+            messages = self.message_buffer
             self.message_buffer = []
             self.lock.release()
 
-            ws_server.lock.acquire()
-            for client in ws_server.clients:
-                client.send(ws_server.encode_message(keyvals))
-            ws_server.lock.release()
+            # Keep the last set or delete of each key. Only delete keys sent
+            # to clients before.
+            latest = collections.OrderedDict()
+            for key, val in messages:
+                latest[key] = val
+            keyvals = [(key, val) for key, val in latest.items() if val is not None]
+            del_keys = [key for key, val in latest.items()
+                        if val is None and self.snapshot.get(key) is not None]
+            if not keyvals and not del_keys:
+                continue
+
+            self.broadcast(ws_server, keyvals, del_keys)
 
     def parse_val(self, key, skip_unchanged=True):
         """
@@ -100,8 +124,73 @@ class RedisMonitor:
             # Otherwise, leave it as a string
             pass
 
+        self.latency_monitor.on_read(key, val)
         return val
 
+    def broadcast(self, ws_server, key_vals, del_keys):
+        """
+        Apply updates to the snapshot and send them to the web socket clients:
+        every key to clients without a subscription, and only the keys of
+        their namespaces to subscribed clients.
+        """
+
+        key_vals = [(key.decode("utf-8") if type(key) is bytes else key, val) for key, val in key_vals]
+
+        # Hold the client list lock so joining clients see either the snapshot
+        # before this update and the update, or the snapshot after it
+        ws_server.lock.acquire()
+        try:
+            new_refs = []
+            for key, val in key_vals:
+                self.snapshot.update(key, val)
+                new_refs += self.subscriptions.update(key, val)
+            for key in del_keys:
+                self.snapshot.delete(key)
+
+            message = None
+            for client in ws_server.clients:
+                if self.subscriptions.is_subscribed(client):
+                    continue
+                if message is None:
+                    message = ws_server.encode_message({"update": key_vals, "delete": del_keys})
+                client.send(message)
+
+            # Models that start referencing a key also need its current value
+            updated = set(key for key, _ in key_vals)
+            key_vals_routed = key_vals + [(key, self.snapshot.get(key)) for key in new_refs
+                                          if key not in updated and self.snapshot.get(key) is not None]
+            for clients, updates, deletes in self.subscriptions.fan_out(key_vals_routed, del_keys):
+                message = ws_server.encode_message({"update": updates, "delete": deletes})
+                for client in clients:
+                    client.send(message)
+
+            for key in del_keys:
+                self.subscriptions.delete(key)
+        finally:
+            ws_server.lock.release()
+        self.latency_monitor.on_sent([key for key, _ in key_vals])
+
+    def _initialize_snapshot(self, ws_server):
+        """
+        Read all Redis keys into the snapshot once. Afterwards, the snapshot
+        is kept up to date with the updates sent to the clients.
+        """
+
+        key_vals = []
+        for key in sorted(self.redis_db.scan_iter()):
+            if self.redis_db.type(key) != b"string":
+                continue
+
+            key = key.decode("utf-8")
+            val = self.parse_val(key, skip_unchanged=False)
+            if val is None:
+                continue
+
+            key_vals.append((key, val))
+
+        self.broadcast(ws_server, key_vals, [])
+        return set(key for key, _ in key_vals if "high_res" not in key)
+
     def _initialize_redis_keys(self):
         import json
         interaction = {
@@ -120,11 +209,12 @@ class RedisMonitor:
         and send updated values to all web socket clients every refresh_rate seconds.
         """
         self._initialize_redis_keys()
+        prev_keys = self._initialize_snapshot(ws_server)
         if not self.realtime:
             # Send messages to clients every refresh_rate seconds
-            prev_keys = set()
             while True:
                 time.sleep(self.refresh_rate)
+                self.latency_monitor.maybe_report()
 
                 key_vals = []
                 new_keys = set()
@@ -149,10 +239,7 @@ class RedisMonitor:
                 for key in del_keys:
                     self.message_last.pop(key, None)
 
-                ws_server.lock.acquire()
-                for client in ws_server.clients:
-                    client.send(ws_server.encode_message({"update": key_vals, "delete": del_keys}))
-                ws_server.lock.release()
+                self.broadcast(ws_server, key_vals, del_keys)
 
         else:
             # Create thread to send messages to client with refresh rate
@@ -165,10 +252,15 @@ class RedisMonitor:
                 if msg["pattern"] is None:
                     continue
 
-                key = msg["data"]
-                val = self.parse_val(key)
-                if val is None:
-                    continue
+                key = msg["data"].decode("utf-8")
+                if msg["channel"].endswith(b":set"):
+                    val = self.parse_val(key)
+                    if val is None:
+                        continue
+                else:
+                    # Deleted, buffered as None
+                    self.message_last.pop(key, None)
+                    val = None
 
                 self.lock.acquire()
                 self.message_buffer.append((key, val))
@@ -176,21 +268,30 @@ class RedisMonitor:
 
     def initialize_client(self, ws_server, client):
         """
-        On first connection, send client all Redis keys.
-        """
+        On first connection, subscribe the client to the namespaces in its
+        request path and send it the snapshot of its keys.
 
-        key_vals = []
+        This is called with the client list lock held, so the client receives
+        every update after the snapshot, and other clients are not affected.
+        """
 
-        # TODO: Don't disrupt other clients
-        self.message_last = {}
-        for key in sorted(self.redis_db.scan_iter()):
-            if self.redis_db.type(key) != b"string":
-                continue
+        namespaces = SubscriptionIndex.parse_namespaces(ws_server.paths.get(client, "/"))
+        self.subscriptions.subscribe(client, namespaces)
+        if namespaces is None:
+            client.send(ws_server.encode_bytes(b"".join(self.snapshot.join())))
+            return
 
-            val = self.parse_val(key, skip_unchanged=False)
-            if val is None:
-                continue
+        key_vals = [(key, val) for key, val in self.snapshot.items()
+                    if self.subscriptions.route(key) & namespaces]
+        client.send(ws_server.encode_message({"update": key_vals, "delete": []}))
 
-            key_vals.append((key.decode("utf-8"), val))
+    def handle_client_message(self, ws_server, client, message):
+        """
+        Handle messages from clients (currently only latency reports), and
+        unsubscribe disconnected clients.
+        """
 
-        client.send(ws_server.encode_message({"update": key_vals, "delete": []}))
+        if message is None:
+            self.subscriptions.unsubscribe(client)
+            return
+        self.latency_monitor.on_browser_message(message)
@@ -0,0 +1,178 @@
+"""
+ResourceResolver.py
+
+Author: Toki Migimatsu
+Created: October 2026
+"""
+
+from __future__ import print_function, division
+import os
+import threading
+
+
+class ResourceResolver:
+    """
+    Resolve "/resources/<app>/<path>" requests to files inside the directories
+    registered with RegisterResourcePath.
+
+    The directories of each app are read from Redis once, and the file each
+    path resolves to is cached. Both are invalidated by keyspace notifications
+    when RegisterResourcePath or UnregisterResourcePath modify
+    "webapp::resources::<app>". If notifications cannot be enabled, the
+    directories are read from Redis on every request.
+
+    The listener thread is started on the first request, so the resolver can be
+    created before forking the HTTP server process.
+
+    Usage:
+
+    resolver = ResourceResolver(redis_db, db=0)
+    resolved = resolver.resolve("simulator", ["meshes", "link0.obj"])
+    if resolved is not None:
+        path, path_gz = resolved
+    """
+
+    KEY_RESOURCES_PREFIX = "webapp::resources::"
+
+    def __init__(self, redis_db, db=0):
+        self.redis_db = redis_db
+        self.db = db
+        self.lock = threading.Lock()
+
+        # App -> list of registered directories
+        self.directories = {}
+
+        # (app, path tokens) -> (path, path of the gzipped variant or None)
+        self.paths = {}
+
+        # Incremented on every invalidation, so lookups that raced with one
+        # are not cached
+        self.generation = 0
+
+        # Process that started the listener, and whether it is running
+        self.pid = None
+        self.listening = False
+
+    def resolve(self, app, path_tokens):
+        """
+        Return (path, path_gz) of the first registered directory containing
+        the file, where path_gz is its precompressed "<path>.gz" variant if one
+        exists, or None if no directory contains the file.
+        """
+        self._start_listener()
+
+        key = (app, tuple(path_tokens))
+        with self.lock:
+            resolved = self.paths.get(key)
+            generation = self.generation
+        if resolved is not None:
+            return resolved
+
+        for directory in self._get_directories(app, generation):
+            path = os.path.join(directory, *path_tokens)
+            if not os.path.isfile(path):
+                continue
+            path_gz = path + ".gz"
+            resolved = (path, path_gz if os.path.isfile(path_gz) else None)
+            break
+        else:
+            return None
+
+        with self.lock:
+            if self.listening and self.generation == generation:
+                self.paths[key] = resolved
+        return resolved
+
+    def forget(self, app, path_tokens):
+        """
+        Remove a cached path, e.g. after its file was deleted from disk.
+        """
+        with self.lock:
+            self.paths.pop((app, tuple(path_tokens)), None)
+
+    def invalidate(self, app=None):
+        """
+        Remove the cached directories and paths of an app, or of all apps.
+        """
+        with self.lock:
+            self.generation += 1
+            if app is None:
+                self.directories.clear()
+                self.paths.clear()
+                return
+            self.directories.pop(app, None)
+            for key in [key for key in self.paths if key[0] == app]:
+                del self.paths[key]
+
+    def _get_directories(self, app, generation):
+        with self.lock:
+            directories = self.directories.get(app)
+        if directories is not None:
+            return directories
+
+        members = self.redis_db.smembers(ResourceResolver.KEY_RESOURCES_PREFIX + app)
+        directories = sorted(member.decode("utf-8") if type(member) is bytes else member
+                             for member in members)
+        with self.lock:
+            if self.listening and self.generation == generation:
+                self.directories[app] = directories
+        return directories
+
+    def _start_listener(self):
+        """
+        Subscribe to changes of the resource sets once per process.
+        """
+        with self.lock:
+            if self.pid == os.getpid():
+                return
+            self.pid = os.getpid()
+            self.listening = False
+            self.directories.clear()
+            self.paths.clear()
+
+        #  Need to perform the following command to enable keyspace notifications of set commands:
+        #  config set notify-keyspace-events "Ks"
+        try:
+            notify_keyspace_events = self.redis_db.config_get("notify-keyspace-events")["notify-keyspace-events"]
+            if type(notify_keyspace_events) is bytes:
+                notify_keyspace_events = notify_keyspace_events.decode("utf-8")
+            if "s" not in notify_keyspace_events and "A" not in notify_keyspace_events:
+                notify_keyspace_events += "s"
+            if "K" not in notify_keyspace_events:
+                notify_keyspace_events += "K"
+            self.redis_db.config_set("notify-keyspace-events", notify_keyspace_events)
+
+            pubsub = self.redis_db.pubsub()
+            pubsub.psubscribe("__keyspace@%d__:%s*" % (self.db, ResourceResolver.KEY_RESOURCES_PREFIX))
+
+            # Wait for the subscription so no change is missed after caching
+            if pubsub.get_message(timeout=1.) is None:
+                raise RuntimeError("psubscribe timed out")
+        except Exception as e:
+            print("ResourceResolver: keyspace notifications unavailable, resource paths will not be cached (%s)" % e)
+            return
+
+        with self.lock:
+            self.listening = True
+        listener_thread = threading.Thread(target=self._listen, args=(pubsub,))
+        listener_thread.daemon = True
+        listener_thread.start()
+
+    def _listen(self, pubsub):
+        prefix = "__keyspace@%d__:%s" % (self.db, ResourceResolver.KEY_RESOURCES_PREFIX)
+        try:
+            for message in pubsub.listen():
+                if message["type"] != "pmessage":
+                    continue
+                channel = message["channel"]
+                if type(channel) is bytes:
+                    channel = channel.decode("utf-8")
+                self.invalidate(channel[len(prefix):])
+        except Exception as e:
+            print("ResourceResolver: lost keyspace notifications (%s)" % e)
+
+        # Stop caching until the listener is restarted by the next request
+        with self.lock:
+            self.pid = None
+            self.listening = False
+        self.invalidate()
@@ -0,0 +1,132 @@
+"""
+SceneSnapshot.py
+
+Author: Toki Migimatsu
+Created: October 2026
+"""
+
+from __future__ import print_function, division
+import collections
+import threading
+
+
+class SceneSnapshot:
+    """
+    Versioned snapshot of the keys sent to the web socket clients, so that
+    joining clients don't need to read every key from Redis.
+
+    Every update or deletion increments a generation counter. The snapshot
+    keeps the encoded update message of all keys at some generation, and a
+    joining client is sent that message plus a delta of the keys changed since
+    then. The snapshot is only re-encoded once the delta covers more than half
+    of the keys.
+
+    This mirrors SceneSnapshot in include/redis_gl/scene_snapshot.h.
+
+    Usage:
+
+    snapshot = SceneSnapshot(WebSocketServer.encode_update)
+
+    # Broadcast, under the client list lock
+    snapshot.update(key, val)
+
+    # Join, under the client list lock
+    client.send(WebSocketServer.encode_bytes(b"".join(snapshot.join())))
+    """
+
+    def __init__(self, encode_update):
+        self.encode_update = encode_update
+        self.lock = threading.Lock()
+        self.generation = 0
+
+        # key -> (val, generation, deleted) in order of generation
+        self.entries = collections.OrderedDict()
+
+        self.message_snapshot = None
+        self.generation_snapshot = 0
+
+    def update(self, key, val):
+        """
+        Set the latest value of a key and return the generation. Unchanged
+        values do not increment it.
+        """
+        with self.lock:
+            entry = self.entries.get(key)
+            if entry is not None and not entry[2] and entry[0] == val:
+                return self.generation
+            self.generation += 1
+            self.entries[key] = (val, self.generation, False)
+            self.entries.move_to_end(key)
+            return self.generation
+
+    def delete(self, key):
+        """
+        Delete a key and return the generation.
+        """
+        with self.lock:
+            entry = self.entries.get(key)
+            if entry is None or entry[2]:
+                return self.generation
+            self.generation += 1
+            self.entries[key] = (None, self.generation, True)
+            self.entries.move_to_end(key)
+            return self.generation
+
+    def get(self, key):
+        """
+        Return the latest value of a key, or None if it does not exist.
+        """
+        with self.lock:
+            entry = self.entries.get(key)
+            return None if entry is None or entry[2] else entry[0]
+
+    def items(self):
+        """
+        Return the (key, val) pairs of all keys.
+        """
+        with self.lock:
+            return [(key, entry[0]) for key, entry in self.entries.items() if not entry[2]]
+
+    def join(self):
+        """
+        Return the update message payloads that bring a new client up to date:
+        the snapshot, followed by the delta since its generation if there is
+        one. Send them concatenated as one web socket message.
+        """
+        with self.lock:
+            delta = self._since(self.generation_snapshot)
+            if self.message_snapshot is None or 2 * len(delta) > len(self.entries):
+                self._encode_snapshot()
+                delta = []
+
+            messages = [self.message_snapshot]
+            if delta:
+                messages.append(self.encode_update({
+                    "update": [(key, val) for key, val, deleted in delta if not deleted],
+                    "delete": [key for key, _, deleted in delta if deleted]
+                }))
+            return messages
+
+    def _since(self, generation):
+        """
+        Return the (key, val, deleted) entries changed after the generation.
+        """
+        delta = []
+        for key in reversed(self.entries):
+            val, generation_key, deleted = self.entries[key]
+            if generation_key <= generation:
+                break
+            delta.append((key, val, deleted))
+        delta.reverse()
+        return delta
+
+    def _encode_snapshot(self):
+        # Deleted keys are no longer needed by any joining client
+        for key in [key for key, entry in self.entries.items() if entry[2]]:
+            del self.entries[key]
+
+        self.message_snapshot = self.encode_update({
+            "update": [(key, entry[0]) for key, entry in self.entries.items()],
+            "delete": []
+        })
+        self.generation_snapshot = self.generation
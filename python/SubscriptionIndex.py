@@ -0,0 +1,264 @@
+"""
+SubscriptionIndex.py
+
+Author: Toki Migimatsu
+Created: October 2026
+"""
+
+from __future__ import print_function, division
+import json
+import threading
+
+
+class SubscriptionIndex:
+    """
+    Route keys to the web socket clients subscribed to their namespaces.
+
+    A client subscribes to namespaces registered with RegisterModelKeys by
+    connecting to "ws://<host>:<port>/?namespace=<namespace>[,<namespace>]".
+    Clients without a subscription receive every key.
+
+    A key belongs to a namespace if it is the namespace's args key, starts with
+    "<namespace>::" (models, descriptions, frames and latency stamps), or is a
+    state key referenced by one of the namespace's models (any "key_*" field,
+    plus the "::level::<i>" keys of image pyramids). References are kept up to
+    date from the model values passed to update() and delete().
+
+    Routes are cached per key, and subscribed clients are grouped by their set
+    of namespaces, so routing an update costs one dict lookup plus one entry per
+    subscribed group, regardless of the total number of keys.
+
+    Usage:
+
+    index = SubscriptionIndex()
+    index.subscribe(client, ["app"])
+
+    # Broadcast, under the client list lock
+    new_refs = index.update(key, val)
+    for clients, key_vals, del_keys in index.fan_out(key_vals, del_keys):
+        ...
+    """
+
+    KEY_ARGS_PREFIX = "webapp::simulator::args::"
+    INFIX_MODEL = "::model::"
+
+    def __init__(self):
+        self.lock = threading.Lock()
+
+        # Model key -> (namespace, referenced keys)
+        self.models = {}
+
+        # Referenced key -> {namespace: number of referencing models}
+        self.refs = {}
+
+        # Namespaces with args, models or subscribers
+        self.namespaces = set()
+
+        # Key -> frozenset of namespaces
+        self.routes = {}
+
+        # Client -> frozenset of namespaces, and namespaces -> set of clients
+        self.clients = {}
+        self.groups = {}
+
+        # Namespace -> list of subscribed namespace sets
+        self.groups_by_namespace = {}
+
+    @staticmethod
+    def parse_namespaces(path):
+        """
+        Parse the namespaces of a web socket request path, or return None to
+        subscribe to all keys.
+        """
+        try:
+            from urllib.parse import urlparse, parse_qs
+        except ImportError:
+            from urlparse import urlparse, parse_qs
+
+        query = parse_qs(urlparse(path).query)
+        if "namespace" not in query:
+            return None
+        namespaces = [ns for arg in query["namespace"] for ns in arg.split(",") if ns]
+        return frozenset(namespaces) if namespaces else None
+
+    def subscribe(self, client, namespaces):
+        """
+        Subscribe a client to a set of namespaces, or to all keys if None.
+        """
+        with self.lock:
+            self._unsubscribe(client)
+            if namespaces is None:
+                return
+            namespaces = frozenset(namespaces)
+            self.clients[client] = namespaces
+            if namespaces not in self.groups:
+                self.groups[namespaces] = set()
+                for ns in namespaces:
+                    self.groups_by_namespace.setdefault(ns, []).append(namespaces)
+                if not namespaces <= self.namespaces:
+                    self.namespaces |= namespaces
+                    self.routes.clear()
+            self.groups[namespaces].add(client)
+
+    def unsubscribe(self, client):
+        with self.lock:
+            self._unsubscribe(client)
+
+    def is_subscribed(self, client):
+        return client in self.clients
+
+    def route(self, key):
+        """
+        Return the frozenset of namespaces a key belongs to.
+        """
+        with self.lock:
+            return self._route(key)
+
+    def update(self, key, val):
+        """
+        Index the references of a model value. Return the keys that became
+        referenced by a namespace, whose current values its subscribers need.
+        """
+        idx = key.find(SubscriptionIndex.INFIX_MODEL)
+        is_args = key.startswith(SubscriptionIndex.KEY_ARGS_PREFIX)
+        if idx <= 0 and not is_args:
+            return []
+
+        with self.lock:
+            if is_args:
+                self._add_namespace(key[len(SubscriptionIndex.KEY_ARGS_PREFIX):])
+                return []
+
+            namespace = key[:idx]
+            self._add_namespace(namespace)
+            refs = SubscriptionIndex._parse_refs(val)
+            _, refs_old = self.models.get(key, (namespace, frozenset()))
+            if refs == refs_old:
+                return []
+            self.models[key] = (namespace, refs)
+
+            for ref in refs_old - refs:
+                self._remove_ref(ref, namespace)
+            added = []
+            for ref in refs - refs_old:
+                if self._add_ref(ref, namespace):
+                    added.append(ref)
+            return added
+
+    def delete(self, key):
+        """
+        Remove the references of a deleted model.
+        """
+        with self.lock:
+            if key not in self.models:
+                return
+            namespace, refs = self.models.pop(key)
+            for ref in refs:
+                self._remove_ref(ref, namespace)
+
+    def fan_out(self, key_vals, del_keys):
+        """
+        Split updates among the subscribed client groups.
+
+        Returns a list of (clients, key_vals, del_keys) with the non-empty
+        updates of each group.
+        """
+        with self.lock:
+            if not self.groups:
+                return []
+            batches = {}
+            for key, val in key_vals:
+                for group in self._groups_of(key):
+                    batches.setdefault(group, ([], []))[0].append((key, val))
+            for key in del_keys:
+                for group in self._groups_of(key):
+                    batches.setdefault(group, ([], []))[1].append(key)
+            return [(list(self.groups[group]), updates, deletes)
+                    for group, (updates, deletes) in batches.items()]
+
+    def _groups_of(self, key):
+        route = self._route(key)
+        if len(route) == 1:
+            for ns in route:
+                return self.groups_by_namespace.get(ns, ())
+        groups = set()
+        for ns in route:
+            groups.update(self.groups_by_namespace.get(ns, ()))
+        return groups
+
+    def _route(self, key):
+        route = self.routes.get(key)
+        if route is not None:
+            return route
+
+        namespaces = set(self.refs.get(key, ()))
+        if key.startswith(SubscriptionIndex.KEY_ARGS_PREFIX):
+            namespaces.add(key[len(SubscriptionIndex.KEY_ARGS_PREFIX):])
+        else:
+            # Check every "::"-separated prefix of the key
+            idx = key.find("::")
+            while idx > 0:
+                if key[:idx] in self.namespaces:
+                    namespaces.add(key[:idx])
+                idx = key.find("::", idx + 2)
+
+        route = frozenset(namespaces)
+        self.routes[key] = route
+        return route
+
+    def _add_namespace(self, namespace):
+        if namespace in self.namespaces:
+            return
+        self.namespaces.add(namespace)
+        self.routes.clear()
+
+    def _add_ref(self, ref, namespace):
+        counts = self.refs.setdefault(ref, {})
+        counts[namespace] = counts.get(namespace, 0) + 1
+        self.routes.pop(ref, None)
+        return counts[namespace] == 1
+
+    def _remove_ref(self, ref, namespace):
+        counts = self.refs[ref]
+        counts[namespace] -= 1
+        if counts[namespace] == 0:
+            del counts[namespace]
+            if not counts:
+                del self.refs[ref]
+        self.routes.pop(ref, None)
+
+    def _unsubscribe(self, client):
+        namespaces = self.clients.pop(client, None)
+        if namespaces is None:
+            return
+        group = self.groups[namespaces]
+        group.discard(client)
+        if group:
+            return
+        del self.groups[namespaces]
+        for ns in namespaces:
+            self.groups_by_namespace[ns].remove(namespaces)
+            if not self.groups_by_namespace[ns]:
+                del self.groups_by_namespace[ns]
+
+    @staticmethod
+    def _parse_refs(val):
+        """
+        Return the state keys referenced by a model value.
+        """
+        try:
+            model = json.loads(val)
+        except (TypeError, ValueError):
+            return frozenset()
+        if type(model) is not dict:
+            return frozenset()
+
+        refs = set()
+        num_levels = model.get("num_levels", 1)
+        for field, key in model.items():
+            if not field.startswith("key_") or not isinstance(key, str) or not key:
+                continue
+            refs.add(key)
+            if field.endswith("_image") and isinstance(num_levels, int):
+                refs.update("%s::level::%d" % (key, level) for level in range(1, num_levels))
+        return frozenset(refs)
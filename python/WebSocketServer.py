@@ -55,13 +55,15 @@ class WebSocketServer:
         self.socket.bind(("", self.port))
         self.socket.listen(1)
         self.clients = []
+        self.paths = {}  # Request path of each client
         self.lock = threading.Lock()
 
     def serve_forever(self, client_connection_callback=None, client_message_callback=None):
         """
         Listen for web socket requests and spawn new thread for each client.
 
-        On connection, the thread will call client_connection_callback(WebSocketServer, socket).
+        On connection, the thread will call client_connection_callback(WebSocketServer, socket) while holding
+        the client list lock. The request path of the client is in WebSocketServer.paths[socket].
         On receiving client messages, the thread will call client_message_callback(WebSocketServer, socket).
         """
 
@@ -78,7 +80,8 @@ class WebSocketServer:
 
         # Handshake with client
         client_key = None
-        for line in client.recv(2048).splitlines():
+        lines = client.recv(2048).splitlines()
+        for line in lines:
             if line.startswith(b"Sec-WebSocket-Key"):
                 client_key = line[line.index(b":")+1:].strip()
                 break
@@ -90,19 +93,25 @@ class WebSocketServer:
         accept_key = b64encode(sha1(client_key + WebSocketServer.MAGIC).digest()).decode("utf-8")
         client.send((WebSocketServer.STR_HANDSHAKE % accept_key).encode("utf-8"))
 
-        # Send client all keys
-        if client_connection_callback is not None:
-            client_connection_callback(self, client)
+        # Request path, e.g. "/?namespace=app"
+        request_line = lines[0].split() if lines else []
+        path = request_line[1].decode("utf-8") if len(request_line) > 1 else "/"
 
-        # Add client to list
+        # Send client all keys and add it to the list in one step, so it
+        # receives every message sent after its initial state
         self.lock.acquire()
-        self.clients.append(client)
-        self.lock.release()
+        try:
+            self.paths[client] = path
+            if client_connection_callback is not None:
+                client_connection_callback(self, client)
+            self.clients.append(client)
+        finally:
+            self.lock.release()
 
         # Listen for messages
         while True:
             try:
-                message = client.recv(1024)
+                message = client.recv(65536)
             except:
                 continue
             message = self.decode_message(message)
@@ -114,6 +123,7 @@ class WebSocketServer:
         # Close connection to client
         self.lock.acquire()
         self.clients.remove(client)
+        del self.paths[client]
         self.lock.release()
         client.close()
 
@@ -141,7 +151,7 @@ class WebSocketServer:
         if length < 126:
             b2 = length
             encoded_bytes += struct.pack("!B", b2)  # byte
-        elif length < (2 ** 16) - 1:
+        elif length < 2 ** 16:
             b2 = 126
             encoded_bytes += struct.pack("!BH", b2, length)  # byte, short
         else:
@@ -165,17 +175,27 @@ class WebSocketServer:
         elif type(message) is str:
             message = message.encode("utf-8")
         else:
-            update_message = struct.pack("!L", len(message["update"]))  # long
-            for key, val in message["update"]:
-                update_message += WebSocketServer.encode_bytes(key) + WebSocketServer.encode_bytes(val)
+            message = WebSocketServer.encode_update(message)
+
+        return WebSocketServer.encode_bytes(message)
+
+    @staticmethod
+    def encode_update(message):
+        """
+        Encode a {"update": [(key, val)], "delete": [key]} message as the
+        payload of a web socket message. Several payloads can be concatenated
+        into one web socket message.
+        """
 
-            delete_message = struct.pack("!L", len(message["delete"]))  # long
-            for key in message["delete"]:
-                delete_message += WebSocketServer.encode_bytes(key)
+        update_message = struct.pack("!L", len(message["update"]))  # long
+        for key, val in message["update"]:
+            update_message += WebSocketServer.encode_bytes(key) + WebSocketServer.encode_bytes(val)
 
-            message = update_message + delete_message
+        delete_message = struct.pack("!L", len(message["delete"]))  # long
+        for key in message["delete"]:
+            delete_message += WebSocketServer.encode_bytes(key)
 
-        return WebSocketServer.encode_bytes(message)
+        return update_message + delete_message
 
     @staticmethod
     def decode_message(message):
@@ -1 +1,8 @@
 from .redisgl import *
+
+try:
+    # C++ state publishers, built with -DREDIS_GL_BUILD_PYTHON=ON
+    from ._redisgl import CodecPrecision, StatePublisher
+    from ._redisgl import encode_poses, encode_quaternions, encode_vectors
+except ImportError:
+    pass
@@ -162,6 +162,12 @@ class ModelKeys:
     key_objects_prefix: str
     key_trajectories_prefix: str
     key_cameras_prefix: str
+    key_object_batches_prefix: str
+    key_descriptions_prefix: str
+    key_frame: str
+    key_registry: str
+    key_latency: str
+    key_latency_stamps_prefix: str
 
     def __init__(self, key_namespace: str):
         self.key_namespace = key_namespace
@@ -169,6 +175,12 @@ class ModelKeys:
         self.key_objects_prefix = key_namespace + "::model::object::"
         self.key_trajectories_prefix = key_namespace + "::model::trajectory::"
         self.key_cameras_prefix = key_namespace + "::model::camera::"
+        self.key_object_batches_prefix = key_namespace + "::model::object_batch::"
+        self.key_descriptions_prefix = key_namespace + "::description::"
+        self.key_frame = key_namespace + "::frame"
+        self.key_registry = key_namespace + "::registry"
+        self.key_latency = key_namespace + "::latency"
+        self.key_latency_stamps_prefix = key_namespace + "::latency::stamp::"
 
     def to_dict(self) -> dict[str, Any]:
         return {
@@ -176,6 +188,9 @@ class ModelKeys:
             "key_objects_prefix": self.key_objects_prefix,
             "key_trajectories_prefix": self.key_trajectories_prefix,
             "key_cameras_prefix": self.key_cameras_prefix,
+            "key_object_batches_prefix": self.key_object_batches_prefix,
+            "key_descriptions_prefix": self.key_descriptions_prefix,
+            "key_frame": self.key_frame,
         }
 
 
@@ -203,12 +218,76 @@ class ObjectModel:
         }
 
 
+@dataclasses.dataclass
+class ObjectBatchModel:
+    """Many instances of the same graphics published together in one key.
+
+    The instances are packed with `pack_object_batch()`.
+    """
+
+    name: str
+    graphics: Graphics
+    key_instances: str
+
+    def to_dict(self) -> dict[str, Any]:
+        return {
+            "name": self.name,
+            "graphics": self.graphics.to_dict(),
+            "key_instances": self.key_instances,
+        }
+
+
+OBJECT_BATCH_MAGIC = b"\xffRGI"
+OBJECT_BATCH_VERSION = 1
+OBJECT_BATCH_SCALES = 1 << 0
+OBJECT_BATCH_COLORS = 1 << 1
+
+
+def pack_object_batch(
+    pos: np.ndarray,
+    quat: np.ndarray,
+    scale: np.ndarray | None = None,
+    rgb: np.ndarray | None = None,
+) -> bytes:
+    """Packs the instances of an object batch (see object_batch.h).
+
+    Args:
+        pos: (N, 3) positions.
+        quat: (N, 4) xyzw quaternions.
+        scale: Optional (N, 3) scales.
+        rgb: Optional (N, 3) colors with components in [0, 1].
+    """
+    pos = np.asarray(pos, dtype=np.float32).reshape(-1, 3)
+    quat = np.asarray(quat, dtype=np.float32).reshape(-1, 4)
+    if pos.shape[0] != quat.shape[0]:
+        raise ValueError("pos and quat must have the same number of instances.")
+
+    flags = 0
+    buffers = [np.concatenate((pos, quat), axis=1).astype("<f4").tobytes()]
+    if scale is not None:
+        flags |= OBJECT_BATCH_SCALES
+        buffers.append(np.asarray(scale, dtype="<f4").reshape(-1, 3).tobytes())
+    if rgb is not None:
+        flags |= OBJECT_BATCH_COLORS
+        rgb = np.clip(np.asarray(rgb, dtype=np.float64).reshape(-1, 3), 0.0, 1.0)
+        buffers.append(np.round(255.0 * rgb).astype(np.uint8).tobytes())
+
+    header = (
+        OBJECT_BATCH_MAGIC
+        + bytes([OBJECT_BATCH_VERSION, flags, 0, 0])
+        + int(pos.shape[0]).to_bytes(4, "little")
+        + bytes(4)
+    )
+    return header + b"".join(buffers)
+
+
 @dataclasses.dataclass
 class RobotModel:
     articulated_body: dyn.ArticulatedBody
     key_q: str
     key_pos: str = ""
     key_ori: str = ""
+    key_link_transforms: str = ""
 
     def to_dict(self) -> dict[str, Any]:
         return {
@@ -216,6 +295,7 @@ class RobotModel:
             "key_q": self.key_q,
             "key_pos": self.key_pos,
             "key_ori": self.key_ori,
+            "key_link_transforms": self.key_link_transforms,
         }
 
 
@@ -227,6 +307,8 @@ class CameraModel:
     key_intrinsic: str
     key_depth_image: str
     key_color_image: str
+    num_levels: int = 1
+    key_point_cloud: str = ""
 
     def to_dict(self) -> dict[str, Any]:
         return {
@@ -236,6 +318,8 @@ class CameraModel:
             "key_intrinsic": self.key_intrinsic,
             "key_depth_image": self.key_depth_image,
             "key_color_image": self.key_color_image,
+            "num_levels": self.num_levels,
+            "key_point_cloud": self.key_point_cloud,
         }
 
 
@@ -243,11 +327,13 @@ class CameraModel:
 class TrajectoryModel:
     name: str
     key_pos: str
+    key_samples: str = ""
 
     def to_dict(self) -> dict[str, Any]:
         return {
             "name": self.name,
             "key_pos": self.key_pos,
+            "key_samples": self.key_samples,
         }
 
 
@@ -293,6 +379,32 @@ def unregister_model_keys(redis: ctrlutils.RedisClient, model_keys: ModelKeys) -
     redis.delete(f"{KEY_ARGS}::{model_keys.key_namespace}")
 
 
+def list_model_keys(redis: ctrlutils.RedisClient, model_keys: ModelKeys) -> set[str]:
+    """Lists the model keys registered in an app's namespace.
+
+    Args:
+        redis: Redis client.
+        model_keys: Redisgl app namespace.
+    """
+    return {
+        key.decode("utf-8") if isinstance(key, bytes) else key
+        for key in redis.smembers(model_keys.key_registry)
+    }
+
+
+def clear_model_keys(redis: ctrlutils.RedisClient, model_keys: ModelKeys) -> None:
+    """Unregisters all models in an app's namespace.
+
+    Args:
+        redis: Redis client.
+        model_keys: Redisgl app namespace.
+    """
+    keys = list(list_model_keys(redis, model_keys))
+    for i in range(0, len(keys), 512):
+        redis.unlink(*keys[i : i + 512])
+    redis.unlink(model_keys.key_registry)
+
+
 def register_object(
     redis: ctrlutils.RedisClient, model_keys: ModelKeys, object: ObjectModel
 ) -> None:
@@ -303,7 +415,9 @@ def register_object(
         model_keys: Redisgl app namespace.
         object_model: Object model.
     """
-    redis.set(model_keys.key_objects_prefix + object.name, json.dumps(object.to_dict()))
+    key = model_keys.key_objects_prefix + object.name
+    redis.set(key, json.dumps(object.to_dict()))
+    redis.sadd(model_keys.key_registry, key)
 
 
 def unregister_object(
@@ -316,7 +430,39 @@ def unregister_object(
         name: Object name.espace.
         object_model: Object model.
     """
-    redis.delete(model_keys.key_objects_prefix + name)
+    key = model_keys.key_objects_prefix + name
+    redis.delete(key)
+    redis.srem(model_keys.key_registry, key)
+
+
+def register_object_batch(
+    redis: ctrlutils.RedisClient, model_keys: ModelKeys, batch: ObjectBatchModel
+) -> None:
+    """Registers an object batch with redisgl.
+
+    Args:
+        redis: Redis client.
+        model_keys: Redisgl app namespace.
+        batch: Object batch model.
+    """
+    key = model_keys.key_object_batches_prefix + batch.name
+    redis.set(key, json.dumps(batch.to_dict()))
+    redis.sadd(model_keys.key_registry, key)
+
+
+def unregister_object_batch(
+    redis: ctrlutils.RedisClient, model_keys: ModelKeys, name: str
+) -> None:
+    """Unregisters an object batch with redisgl.
+
+    Args:
+        redis: Redis client.
+        model_keys: Redisgl app namespace.
+        name: Object batch name.
+    """
+    key = model_keys.key_object_batches_prefix + name
+    redis.delete(key)
+    redis.srem(model_keys.key_registry, key)
 
 
 def register_robot(
@@ -329,10 +475,9 @@ def register_robot(
         model_keys: Redisgl app namespace.
         robot: Robot model.
     """
-    redis.set(
-        model_keys.key_robots_prefix + robot.articulated_body.name,
-        json.dumps(robot.to_dict()),
-    )
+    key = model_keys.key_robots_prefix + robot.articulated_body.name
+    redis.set(key, json.dumps(robot.to_dict()))
+    redis.sadd(model_keys.key_registry, key)
 
 
 def unregister_robot(
@@ -345,7 +490,9 @@ def unregister_robot(
         model_keys: Redisgl app namespace.
         robot: Robot model.
     """
-    redis.delete(model_keys.key_robots_prefix + robot.articulated_body.name)
+    key = model_keys.key_robots_prefix + robot.articulated_body.name
+    redis.delete(key)
+    redis.srem(model_keys.key_registry, key)
 
 
 def register_camera(
@@ -358,10 +505,9 @@ def register_camera(
         model_keys: Redisgl app namespace.
         camera: Camera model.
     """
-    redis.set(
-        model_keys.key_cameras_prefix + camera.name,
-        json.dumps(camera.to_dict()),
-    )
+    key = model_keys.key_cameras_prefix + camera.name
+    redis.set(key, json.dumps(camera.to_dict()))
+    redis.sadd(model_keys.key_registry, key)
 
 
 def unregister_camera(
@@ -374,7 +520,9 @@ def unregister_camera(
         model_keys: Redisgl app namespace.
         camera: Camera model.
     """
-    redis.delete(model_keys.key_cameras_prefix + camera.name)
+    key = model_keys.key_cameras_prefix + camera.name
+    redis.delete(key)
+    redis.srem(model_keys.key_registry, key)
 
 
 def register_trajectory(
@@ -387,10 +535,9 @@ def register_trajectory(
         model_keys: Redisgl app namespace.
         trajectory: Trajectory model.
     """
-    redis.set(
-        model_keys.key_trajectories_prefix + trajectory.name,
-        json.dumps(trajectory.to_dict()),
-    )
+    key = model_keys.key_trajectories_prefix + trajectory.name
+    redis.set(key, json.dumps(trajectory.to_dict()))
+    redis.sadd(model_keys.key_registry, key)
 
 
 def unregister_trajectory(
@@ -403,4 +550,6 @@ def unregister_trajectory(
         model_keys: Redisgl app namespace.
         trajectory: Trajectory model.
     """
-    redis.delete(model_keys.key_trajectories_prefix + trajectory.name)
+    key = model_keys.key_trajectories_prefix + trajectory.name
+    redis.delete(key)
+    redis.srem(model_keys.key_registry, key)
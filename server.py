@@ -14,19 +14,31 @@ from multiprocessing import Process
 from argparse import ArgumentParser
 import json
 import os
-import shutil
 
 import sys
 WEB_DIRECTORY = os.path.join(os.path.dirname(__file__), "web")
 sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), "python")))
 from RedisMonitor import RedisMonitor
+from ResourceResolver import ResourceResolver
 from WebSocketServer import WebSocketServer
 from HTTPRequestHandler import makeHTTPRequestHandler
 
 if sys.version.startswith("3"):
     from http.server import HTTPServer
+    from socketserver import ThreadingMixIn
+    from urllib.parse import urlparse, unquote
 else:
     from BaseHTTPServer import HTTPServer
+    from SocketServer import ThreadingMixIn
+    from urlparse import urlparse
+    from urllib import unquote
+
+class ThreadingHTTPServer(ThreadingMixIn, HTTPServer):
+    """
+    HTTPServer that handles each request in a thread, so the browser can load
+    resources in parallel.
+    """
+    daemon_threads = True
 
 args = None
 app_thread = None
@@ -40,15 +52,18 @@ def start_app(app_name, app_target):
     app_thread = Process(target=app_target)
     app_thread.start()
 
-def make_handle_get_request(redis_monitor):
+def make_handle_get_request(resource_resolver):
     def handle_get_request(request_handler, get_vars, **kwargs):
         """
         HTTPRequestHandler callback:
 
-        Serve content inside WEB_DIRECTORY
+        Serve content inside WEB_DIRECTORY and registered resource directories
         """
         global app_thread
-        path_tokens = [token for token in request_handler.path.split("/") if token]
+
+        # Ignore url parameters, e.g. "simulator.html?ws_port=8002"
+        path = unquote(urlparse(request_handler.path).path)
+        path_tokens = [token for token in path.split("/") if token]
 
         apps = {
             #"dh": dh_app,
@@ -58,21 +73,23 @@ def make_handle_get_request(redis_monitor):
         if not path_tokens or ".." in path_tokens:
             request_path = os.path.join(WEB_DIRECTORY, "index.html")
         elif path_tokens[0] == "get_websocket_port":
+            request_handler.set_headers()
             request_handler.wfile.write(str(kwargs["ws_port"]).encode("utf-8"))
             return
         elif len(path_tokens) > 2 and path_tokens[0] == "resources":
-            path_resources = redis_monitor.redis_db.smembers("webapp::resources::{}".format(path_tokens[1]))
-            request_path = None
-            if path_resources is not None:
-                for path_resource in path_resources:
-                    request_path = os.path.join(path_resource.decode("utf-8"), *path_tokens[2:])
-                    print(request_path)
-                    if os.path.isfile(request_path):
-                        break
-                    request_path = None
-
-            if request_path is None:
-                request_path = os.path.join(WEB_DIRECTORY, *path_tokens)
+            resolved = resource_resolver.resolve(path_tokens[1], path_tokens[2:])
+            if resolved is not None:
+                request_path, path_gz = resolved
+                if request_handler.send_file(request_path, path_gz):
+                    return
+
+                # The file was removed since it was resolved
+                resource_resolver.forget(path_tokens[1], path_tokens[2:])
+                resolved = resource_resolver.resolve(path_tokens[1], path_tokens[2:])
+                if resolved is not None and request_handler.send_file(*resolved):
+                    return
+
+            request_path = os.path.join(WEB_DIRECTORY, *path_tokens)
         else:
             file_ext = os.path.splitext(path_tokens[0])
             if len(file_ext) == 2 and file_ext[1] == ".html" and file_ext[0] in apps:
@@ -85,15 +102,10 @@ def make_handle_get_request(redis_monitor):
                 app_thread.start()
             request_path = os.path.join(WEB_DIRECTORY, *path_tokens)
 
-        # Check if file exists
-        if not os.path.isfile(request_path):
+        # Send file directly, or 404 if it doesn't exist
+        if not os.path.isfile(request_path) or not request_handler.send_file(request_path):
             print(request_path)
             request_handler.send_error(404, "File not found.")
-            return
-
-        # Otherwise send file directly
-        with open(request_path, "rb") as f:
-            shutil.copyfileobj(f, request_handler.wfile)
 
     return handle_get_request
 
@@ -161,8 +173,10 @@ if __name__ == "__main__":
                                  refresh_rate=args.refresh_rate, key_filter=args.key_filter, realtime=args.realtime)
     print("Connected to Redis database at %s:%d (db %d)" % (args.redis_host, args.redis_port, args.redis_db))
     get_post_args = {"ws_port": args.ws_port, "redis_db": redis_monitor.redis_db}
-    http_server = HTTPServer(("", args.http_port),
-                             makeHTTPRequestHandler(make_handle_get_request(redis_monitor), handle_post_request, get_post_args))
+    resource_resolver = ResourceResolver(redis_monitor.redis_db, db=args.redis_db)
+    http_server = ThreadingHTTPServer(("", args.http_port),
+                                      makeHTTPRequestHandler(make_handle_get_request(resource_resolver),
+                                                             handle_post_request, get_post_args))
     ws_server = WebSocketServer(port=args.ws_port)
 
     # Start HTTPServer
@@ -171,7 +185,7 @@ if __name__ == "__main__":
     print("Started HTTP server on port %d" % (args.http_port))
 
     # Start WebSocketServer
-    ws_server_thread = threading.Thread(target=ws_server.serve_forever, args=(redis_monitor.initialize_client,))
+    ws_server_thread = threading.Thread(target=ws_server.serve_forever, args=(redis_monitor.initialize_client, redis_monitor.handle_client_message))
     ws_server_thread.daemon = True
     ws_server_thread.start()
     print("Started WebSocket server on port %d\n" % (args.ws_port))
@@ -0,0 +1,71 @@
+/**
+ * mesh_preprocess.cc
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ *
+ * Decimates and quantizes the OBJ and STL meshes of a resource directory into
+ * a cache directory of compact levels of detail. Register the cache directory
+ * with RegisterResourcePath() so the viewer loads the compact meshes.
+ *
+ * Usage: redis_gl_mesh_preprocess <resource dir> <cache dir>
+ *                                 [--max_triangles=50000] [--num_lods=3]
+ *                                 [--lod_ratio=0.2] [--min_triangles=500]
+ */
+
+#include <redis_gl/mesh.h>
+
+// std
+#include <exception>  // std::exception
+#include <iostream>   // std::cout, std::cerr
+#include <string>     // std::string, std::stod, std::stoul
+#include <vector>     // std::vector
+
+int main(int argc, char* argv[]) {
+  redis_gl::simulator::MeshPreprocessOptions options;
+  std::vector<std::string> paths;
+  try {
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (arg.compare(0, 2, "--") != 0) {
+        paths.push_back(arg);
+        continue;
+      }
+      const size_t idx_eq = arg.find('=');
+      const std::string name = arg.substr(2, idx_eq - 2);
+      const std::string value =
+          idx_eq == std::string::npos ? "" : arg.substr(idx_eq + 1);
+      if (name == "max_triangles") {
+        options.max_triangles = std::stoul(value);
+      } else if (name == "num_lods") {
+        options.num_lods = std::stoul(value);
+      } else if (name == "lod_ratio") {
+        options.lod_ratio = std::stod(value);
+      } else if (name == "min_triangles") {
+        options.min_triangles = std::stoul(value);
+      } else {
+        throw std::invalid_argument("unknown flag " + arg + ".");
+      }
+    }
+    if (paths.size() != 2) throw std::invalid_argument("expected 2 paths.");
+  } catch (const std::exception& e) {
+    std::cerr << "redis_gl_mesh_preprocess: " << e.what() << std::endl
+              << "Usage: redis_gl_mesh_preprocess <resource dir> <cache dir>"
+              << " [--max_triangles=50000] [--num_lods=3] [--lod_ratio=0.2]"
+              << " [--min_triangles=500]" << std::endl;
+    return 1;
+  }
+
+  try {
+    const size_t num_written =
+        redis_gl::simulator::PreprocessResources(paths[0], paths[1], options);
+    std::cout << "Preprocessed " << num_written << " meshes into " << paths[1]
+              << "." << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "redis_gl_mesh_preprocess: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
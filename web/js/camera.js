@@ -7,11 +7,22 @@
  * Authors: Toki Migimatsu
  */
 
+import * as Codec from "./codec.js"
 import * as Redis from "./redis.js"
 
 let DOWNSCALE_FACTOR = 1;
 
-export function create(key, loadCallback) {
+// Per-frame time budget in ms for decoding and back-projecting a depth image.
+// Cameras that publish pyramid levels switch to a coarser level when over
+// budget and back to a finer one when well under budget.
+let FRAME_TIME_BUDGET = 10;
+let NUM_FRAMES_LEVEL_SWITCH = 10;
+
+// Time in ms without frames at the current level before falling back to
+// level 0, which is always published.
+let LEVEL_TIMEOUT = 500;
+
+export function create(model, loadCallback) {
 	let camera = new THREE.Object3D();
 
 	// Create point cloud
@@ -35,6 +46,17 @@ export function create(key, loadCallback) {
 	}
 	camera.add(frame);
 
+	// Create world-frame point cloud published by PointCloudPublisher. Its
+	// vertices are already in the world frame, so ignore the camera pose.
+	let worldGeometry = new THREE.BufferGeometry();
+	let worldMaterial = new THREE.PointsMaterial({ size: 0.01, vertexColors: THREE.VertexColors });
+	let worldPoints = new THREE.Points(worldGeometry, worldMaterial);
+	worldPoints.frustumCulled = false;
+	worldPoints.onBeforeRender = () => {
+		worldPoints.matrixWorld.identity();
+	};
+	camera.add(worldPoints);
+
 	// Add custom field to THREE.Object3D
 	camera.redisgl = {
 		colorImage: null,
@@ -42,6 +64,18 @@ export function create(key, loadCallback) {
 		depthDim: [0, 0, 0],
 		colorDim: [0, 0, 0],
 		intrinsic: null,
+		depthScale: 0.001,
+		depthLevelScale: 1,
+		level: 0,
+		numLevels: model["num_levels"] || 1,
+		// Levels published in the depth and color image headers
+		numLevelsPublished: {
+			depth: model["num_levels"] || 1,
+			color: model["num_levels"] || 1,
+		},
+		tLevelFrame: 0,
+		frameTime: 0,
+		numFrames: 0,
 	};
 
 	loadCallback(camera);
@@ -54,13 +88,13 @@ export function updateIntrinsic(camera, val) {
 }
 
 export function updatePosition(camera, val) {
-	const pos = Redis.makeNumeric(val[0]);
+	const pos = Codec.toVector(val);
 	camera.position.fromArray(pos);
 	return true;
 }
 
 export function updateOrientation(camera, val) {
-	const quat = Redis.makeNumeric(val[0]);
+	const quat = Codec.toQuaternion(val);
 	camera.quaternion.set(quat[0], quat[1], quat[2], quat[3]);
 	return true;
 }
@@ -187,20 +221,195 @@ function parseOpenCvMat(opencv_mat) {
 	return [promise_img, [numRows, numCols, numChannels]];
 }
 
+let REDISGL_IMAGE_MAGIC = [0xff, 0x52, 0x47, 0x4c];  // "\xffRGL"
+let REDISGL_IMAGE_HEADER_SIZE = 24;
+
+function isRedisGlImage(buffer) {
+	if (buffer.byteLength < REDISGL_IMAGE_HEADER_SIZE) return false;
+	const magic = new Uint8Array(buffer, 0, REDISGL_IMAGE_MAGIC.length);
+	return REDISGL_IMAGE_MAGIC.every((byte, i) => magic[i] === byte);
+}
+
+/**
+ * Decodes the left-predicted, zigzag-encoded samples written by
+ * redis_gl::simulator::ImagePublisher (ImageCompression::kDeltaVarint).
+ */
+function decodeDeltaVarint(bytes, img, stride, numChannels) {
+	const is8Bit = img.BYTES_PER_ELEMENT === 1;
+	let idx = 0;
+	const readVarint = () => {
+		let val = 0;
+		let shift = 0;
+		let byte;
+		do {
+			byte = bytes[idx++];
+			val += (byte & 0x7f) * Math.pow(2, shift);
+			shift += 7;
+		} while (byte & 0x80);
+		return val;
+	};
+	const predict = (k) => {
+		if (k % stride >= numChannels) return img[k - numChannels];
+		if (k >= stride) return img[k - stride];
+		return 0;
+	};
+
+	let k = 0;
+	while (k < img.length) {
+		const zigzag = is8Bit ? bytes[idx++] : readVarint();
+		if (zigzag === 0) {
+			// Run of zero residuals
+			const numZeros = readVarint() + 1;
+			for (let j = 0; j < numZeros; j++, k++) {
+				img[k] = predict(k);
+			}
+		} else {
+			// Typed arrays wrap 8-bit residuals modulo 256
+			img[k] = predict(k) + ((zigzag >>> 1) ^ -(zigzag & 1));
+			k++;
+		}
+	}
+}
+
+/**
+ * Parses the compact image format published by
+ * redis_gl::simulator::ImagePublisher.
+ */
+function parseRedisGlImage(buffer) {
+	const dv = new DataView(buffer);
+	const type = dv.getUint8(5);
+	const compression = dv.getUint8(6);
+	const numChannels = dv.getUint8(7);
+	const level = dv.getUint8(8);
+	const numRows = dv.getUint32(12, true);
+	const numCols = dv.getUint32(16, true);
+	const depthScale = dv.getFloat32(20, true);
+
+	const numSamples = numRows * numCols * numChannels;
+	let img = type === 0 ? new Uint16Array(numSamples) : new Uint8Array(numSamples);
+	if (compression === 0) {
+		// Copy bytes since the payload may not be aligned
+		const payload = new Uint8Array(buffer, REDISGL_IMAGE_HEADER_SIZE, img.byteLength);
+		new Uint8Array(img.buffer).set(payload);
+	} else {
+		const payload = new Uint8Array(buffer, REDISGL_IMAGE_HEADER_SIZE);
+		decodeDeltaVarint(payload, img, numCols * numChannels, numChannels);
+	}
+
+	return [Promise.resolve(img), [numRows, numCols, numChannels], depthScale, level];
+}
+
+function parseImage(buffer) {
+	if (isRedisGlImage(buffer)) return parseRedisGlImage(buffer);
+
+	// OpenCV depth images are in mm.
+	const [promise_img, dim] = parseOpenCvMat(buffer);
+	return [promise_img, dim, 0.001, 0];
+}
+
+/**
+ * Returns whether to render an image of the given level. Limits the camera's
+ * level to the levels the publisher writes, and falls back to level 0 if no
+ * image of the current level has arrived in LEVEL_TIMEOUT.
+ */
+function acceptLevel(spec, buffer, level, image) {
+	// Images without a header only have level 0
+	const numLevels = isRedisGlImage(buffer) ? new DataView(buffer).getUint8(9) : 1;
+	spec.numLevelsPublished[image] = Math.max(1, numLevels);
+	spec.numLevels = Math.min(spec.numLevelsPublished.depth, spec.numLevelsPublished.color);
+	if (spec.level >= spec.numLevels) {
+		spec.level = spec.numLevels - 1;
+		spec.numFrames = 0;
+	}
+
+	const tNow = performance.now();
+	if (level !== spec.level) {
+		if (level !== 0 || tNow - spec.tLevelFrame < LEVEL_TIMEOUT) return false;
+		spec.level = 0;
+		spec.numFrames = 0;
+	}
+	spec.tLevelFrame = tNow;
+	return true;
+}
+
+function updateLevel(spec, frameTime) {
+	if (spec.numLevels <= 1) return;
+
+	spec.frameTime = spec.numFrames === 0 ? frameTime : 0.9 * spec.frameTime + 0.1 * frameTime;
+	spec.numFrames++;
+	if (spec.numFrames < NUM_FRAMES_LEVEL_SWITCH) return;
+
+	// Each finer level costs about 4x more, so leave a margin before switching
+	if (spec.frameTime > FRAME_TIME_BUDGET && spec.level < spec.numLevels - 1) {
+		spec.level++;
+		spec.numFrames = 0;
+		spec.tLevelFrame = performance.now();
+	} else if (spec.frameTime < FRAME_TIME_BUDGET / 5 && spec.level > 0) {
+		spec.level--;
+		spec.numFrames = 0;
+	}
+}
+
+let REDISGL_POINT_CLOUD_MAGIC = [0xff, 0x52, 0x47, 0x50];  // "\xffRGP"
+let REDISGL_POINT_CLOUD_HEADER_SIZE = 16;
+
+/**
+ * Uploads the packed world-frame point cloud published by
+ * redis_gl::simulator::PointCloudPublisher.
+ */
+export function updatePointCloud(camera, buffer) {
+	if (buffer.constructor !== ArrayBuffer) return false;
+	if (buffer.byteLength < REDISGL_POINT_CLOUD_HEADER_SIZE) return false;
+	const magic = new Uint8Array(buffer, 0, REDISGL_POINT_CLOUD_MAGIC.length);
+	if (!REDISGL_POINT_CLOUD_MAGIC.every((byte, i) => magic[i] === byte)) return false;
+
+	const dv = new DataView(buffer);
+	const numChannels = dv.getUint8(5);
+	const numPoints = dv.getUint32(8, true);
+	const positions = new Float32Array(buffer, REDISGL_POINT_CLOUD_HEADER_SIZE, 3 * numPoints);
+
+	let geometry = camera.children[2].geometry;
+	let position = geometry.attributes.position;
+	if (position === undefined || position.array.length < positions.length) {
+		// Allocate with headroom so small changes in size reuse the buffer
+		const lenBuffer = Math.ceil(1.5 * positions.length / 3) * 3;
+		position = new THREE.BufferAttribute(new Float32Array(lenBuffer), 3);
+		position.setUsage(THREE.DynamicDrawUsage);
+		geometry.setAttribute("position", position);
+
+		let color = new THREE.BufferAttribute(new Uint8Array(lenBuffer).fill(255), 3, true);
+		color.setUsage(THREE.DynamicDrawUsage);
+		geometry.setAttribute("color", color);
+	}
+	position.array.set(positions);
+	position.needsUpdate = true;
+
+	if (numChannels > 0) {
+		const offset = REDISGL_POINT_CLOUD_HEADER_SIZE + positions.byteLength;
+		geometry.attributes.color.array.set(new Uint8Array(buffer, offset, 3 * numPoints));
+		geometry.attributes.color.needsUpdate = true;
+	}
+	geometry.setDrawRange(0, numPoints);
+	return true;
+}
+
 var updatingDepth = false;
 
-export function updateDepthImage(camera, opencv_mat, renderCallback) {
+export function updateDepthImage(camera, opencv_mat, renderCallback, level) {
 	if (opencv_mat.constructor !== ArrayBuffer) return false;
+	if (!acceptLevel(camera.redisgl, opencv_mat, level || 0, "depth")) return false;
 	if (updatingDepth) return false;
 	updatingDepth = true;
-	const [promise_img, dim] = parseOpenCvMat(opencv_mat);
+	const tStart = performance.now();
+	const [promise_img, dim, depthScale, depthLevel] = parseImage(opencv_mat);
 	promise_img.then((img) => {
 		let spec = camera.redisgl;
-		if (spec.depthImage === null) {
+		let points = camera.children[0];
+		const lenBuffer = 3 * img.length / (DOWNSCALE_FACTOR * DOWNSCALE_FACTOR);
+		if (spec.depthImage === null || points.geometry.attributes.position.array.length < lenBuffer) {
 			// Create new buffer
-			let points = camera.children[0];
 			let geometry = points.geometry;
-			let len_buffer = 3 * img.length / (DOWNSCALE_FACTOR * DOWNSCALE_FACTOR);
+			let len_buffer = lenBuffer;
 			let buffer = new Float32Array(len_buffer);
 			geometry.setAttribute("position", new THREE.Float32BufferAttribute(buffer, 3));
 			geometry.attributes.position.dynamic = true;
@@ -216,9 +425,12 @@ export function updateDepthImage(camera, opencv_mat, renderCallback) {
 		// Update specs
 		spec.depthImage = img;
 		spec.depthDim = dim;
+		spec.depthScale = depthScale;
+		spec.depthLevelScale = Math.pow(2, depthLevel);
 
 		renderCameraViewFrame(camera);
 		renderPointCloud(camera);
+		updateLevel(spec, performance.now() - tStart);
 		if (!updatingColor) {
 			renderCallback(() => {
 				updatingDepth = false;
@@ -232,11 +444,12 @@ export function updateDepthImage(camera, opencv_mat, renderCallback) {
 
 var updatingColor = false;
 
-export function updateColorImage(camera, opencv_mat, renderCallback) {
+export function updateColorImage(camera, opencv_mat, renderCallback, level) {
 	if (opencv_mat.constructor !== ArrayBuffer) return false;
+	if (!acceptLevel(camera.redisgl, opencv_mat, level || 0, "color")) return false;
 	if (updatingColor) return false;
 	updatingColor = true;
-	const [promise_img, dim] = parseOpenCvMat(opencv_mat);
+	const [promise_img, dim] = parseImage(opencv_mat);
 	promise_img.then((img) => {
 		let spec = camera.redisgl;
 		// if (spec.colorImage === null && spec.depthImage === null) {
@@ -271,6 +484,8 @@ function renderPointCloud(camera) {
 	const K = spec.intrinsic;
 	const numRows = spec.depthDim[0];
 	const numCols = spec.depthDim[1];
+	const depthScale = spec.depthScale;
+	const s = spec.depthLevelScale;  // Pyramid level to full resolution
 	let points = camera.children[0];
 	let buffer = points.geometry.attributes.position.array;
 
@@ -280,10 +495,10 @@ function renderPointCloud(camera) {
 		if (y % DOWNSCALE_FACTOR != 0) continue;
 		for (let x = 0; x < numCols; x++) {
 			if (x % DOWNSCALE_FACTOR != 0) continue;
-			let d = spec.depthImage[numCols * y + x] / 1000; // mm to m.
+			let d = spec.depthImage[numCols * y + x] * depthScale;
 			if (isNaN(d) || d <= 0) continue;
-			buffer[3 * idx + 0] = d * (x - K[0][2]) / K[0][0];
-			buffer[3 * idx + 1] = d * ((numRows - y) - K[1][2]) / K[1][1];
+			buffer[3 * idx + 0] = d * (s * x - K[0][2]) / K[0][0];
+			buffer[3 * idx + 1] = d * (s * (numRows - y) - K[1][2]) / K[1][1];
 			buffer[3 * idx + 2] = d;
 			idx++;
 		}
@@ -310,7 +525,7 @@ function renderPointCloud(camera) {
 		for (let x = 0; x < numCols; x++) {
 			if (x % DOWNSCALE_FACTOR != 0) continue;
 			let idxCol = x * numChannels;
-			let d = spec.depthImage[numCols * y + x] / 1000; // mm to m.
+			let d = spec.depthImage[numCols * y + x] * depthScale;
 			if (isNaN(d) || d <= 0) continue;
 			for (let c = 0; c < 3; c++) {
 				colorBuffer[3 * idx + c] = spec.colorImage[idxRow + idxCol + c] / 255;
@@ -328,9 +543,9 @@ function renderCameraViewFrame(camera) {
 	if (spec.intrinsic === null) return false;
 	let frame = camera.children[1];
 
-	// Get pixel coordinates of corners
-	const numRows = spec.depthDim[0];
-	const numCols = spec.depthDim[1];
+	// Get full-resolution pixel coordinates of corners
+	const numRows = spec.depthDim[0] * spec.depthLevelScale;
+	const numCols = spec.depthDim[1] * spec.depthLevelScale;
 	let corners = [[0, 0], [0, numCols - 1], [numRows - 1, numCols - 1], [numRows - 1, 0]];
 
 	// Compute 3D coordinates of corners
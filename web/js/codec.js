@@ -0,0 +1,105 @@
+/**
+ * codec.js
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+import * as Redis from "./redis.js"
+
+// Quantized state values published with include/redis_gl/codec.h.
+let REDISGL_CODEC_MAGIC = [0xff, 0x52, 0x47, 0x51];  // "\xffRGQ"
+let REDISGL_CODEC_HEADER_SIZE = 24;
+let REDISGL_CODEC_VECTORS = 1;
+let REDISGL_CODEC_QUATERNIONS = 2;
+
+export function isEncoded(val) {
+	if (typeof (val) !== "object" || val.constructor !== ArrayBuffer) return false;
+	if (val.byteLength < REDISGL_CODEC_HEADER_SIZE) return false;
+	const magic = new Uint8Array(val, 0, REDISGL_CODEC_MAGIC.length);
+	return REDISGL_CODEC_MAGIC.every((byte, i) => magic[i] === byte);
+}
+
+/**
+ * Decodes a quantized value into typed arrays: numItems vectors of size dim
+ * in item order, and numItems quaternions in xyzw order.
+ */
+export function decode(buffer) {
+	const view = new DataView(buffer);
+	const type = view.getUint8(5);
+	const vectorBits = view.getUint8(6);
+	const quaternionBits = view.getUint8(7);
+	const numItems = view.getUint32(8, true);
+	const dim = view.getUint32(12, true);
+	const resolution = view.getFloat64(16, true);
+
+	let idx = REDISGL_CODEC_HEADER_SIZE;
+	let vectors = null;
+	if (type !== REDISGL_CODEC_QUATERNIONS) {
+		const fixed = vectorBits === 16
+			? new Int16Array(buffer, idx, numItems * dim)
+			: new Int32Array(buffer, idx, numItems * dim);
+		vectors = new Float64Array(fixed.length);
+		for (let i = 0; i < fixed.length; i++) {
+			vectors[i] = resolution * fixed[i];
+		}
+		idx += (fixed.byteLength + 7) & ~7;
+	}
+
+	let quaternions = null;
+	if (type !== REDISGL_CODEC_VECTORS) {
+		const words = new Uint32Array(buffer, idx, numItems * (quaternionBits === 10 ? 1 : 2));
+		const mask = (1 << quaternionBits) - 1;
+		const scale = 2 / ((mask - 1) * Math.SQRT2);
+		quaternions = new Float32Array(4 * numItems);
+		for (let i = 0; i < numItems; i++) {
+			// Split the three components out of the 32 or 64-bit word
+			let c;
+			if (quaternionBits === 10) {
+				const word = words[i];
+				c = [(word >>> 2) & mask, (word >>> 12) & mask, (word >>> 22) & mask];
+			} else {
+				const lo = words[2 * i];
+				const hi = words[2 * i + 1];
+				c = [(lo >>> 2) & mask, ((lo >>> 22) | (hi << 10)) & mask, (hi >>> 10) & mask];
+			}
+
+			const idxMax = words[quaternionBits === 10 ? i : 2 * i] & 3;
+			let sumSquares = 0;
+			for (let j = 0, k = 0; j < 4; j++) {
+				if (j === idxMax) continue;
+				const component = c[k++] * scale - Math.SQRT1_2;
+				quaternions[4 * i + j] = component;
+				sumSquares += component * component;
+			}
+			quaternions[4 * i + idxMax] = Math.sqrt(Math.max(0, 1 - sumSquares));
+		}
+	}
+
+	return {
+		numItems: numItems,
+		dim: dim,
+		vectors: vectors,
+		quaternions: quaternions
+	};
+}
+
+/**
+ * Returns the numeric vector of a quantized or text value.
+ */
+export function toVector(val) {
+	if (!isEncoded(val)) return Redis.makeNumeric(val[0]);
+	const decoded = decode(val);
+	return decoded.vectors !== null ? decoded.vectors : decoded.quaternions;
+}
+
+/**
+ * Returns the xyzw quaternion of a quantized or text value.
+ */
+export function toQuaternion(val) {
+	if (!isEncoded(val)) return Redis.makeNumeric(val[0]);
+	const decoded = decode(val);
+	return decoded.quaternions !== null ? decoded.quaternions : decoded.vectors;
+}
@@ -64,6 +64,100 @@ function loadStl(dir, file) {
 	});
 }
 
+let REDISGL_MESH_MAGIC = [0xff, 0x52, 0x47, 0x4d];  // "\xffRGM"
+let REDISGL_MESH_HEADER_SIZE = 48;
+
+function parseRgm(buffer) {
+	if (buffer.byteLength < REDISGL_MESH_HEADER_SIZE) return null;
+	const magic = new Uint8Array(buffer, 0, REDISGL_MESH_MAGIC.length);
+	if (!REDISGL_MESH_MAGIC.every((byte, i) => magic[i] === byte)) return null;
+
+	const dv = new DataView(buffer);
+	const numLods = dv.getUint8(6);
+	const indexSize = dv.getUint8(7);
+	const numVertices = dv.getUint32(8, true);
+	const numTriangles = dv.getUint32(12, true);
+	const hash = dv.getBigUint64(40, true);
+
+	// Dequantize the positions over the bounding box
+	const quantized = new Uint16Array(buffer, REDISGL_MESH_HEADER_SIZE, 3 * numVertices);
+	let positions = new Float32Array(3 * numVertices);
+	for (let j = 0; j < 3; j++) {
+		const min = dv.getFloat32(16 + 4 * j, true);
+		const scale = (dv.getFloat32(28 + 4 * j, true) - min) / 65535;
+		for (let i = j; i < positions.length; i += 3) {
+			positions[i] = min + scale * quantized[i];
+		}
+	}
+
+	const offset = REDISGL_MESH_HEADER_SIZE + ((6 * numVertices + 3) & ~3);
+	const indices = indexSize === 2 ? new Uint16Array(buffer, offset, 3 * numTriangles)
+	                                : new Uint32Array(buffer, offset, 3 * numTriangles);
+
+	let geometry = new THREE.BufferGeometry();
+	geometry.setAttribute("position", new THREE.BufferAttribute(positions, 3));
+	geometry.setIndex(new THREE.BufferAttribute(indices, 1));
+	geometry.computeBoundingSphere();
+	return { geometry: geometry, numLods: numLods, hash: hash };
+}
+
+function fetchRgm(dir, file, lod) {
+	return fetch(dir + file + ".lod" + lod + ".rgm").then((response) => {
+		if (!response.ok) throw new Error("No preprocessed mesh: " + dir + file);
+		return response.arrayBuffer();
+	}).then((buffer) => {
+		const rgm = parseRgm(buffer);
+		if (rgm === null) throw new Error("Invalid preprocessed mesh: " + dir + file);
+		return rgm;
+	});
+}
+
+function loadRgm(dir, file) {
+	// Resolve with the coarsest level and refine it as the finer levels arrive
+	return fetchRgm(dir, file, 0).then((rgm) => {
+		// Flat shading keeps the hard edges of decimated meshes
+		const material = new THREE.MeshNormalMaterial({ flatShading: true });
+		let mesh = new THREE.Mesh(rgm.geometry, material);
+
+		let refine = Promise.resolve();
+		for (let lod = 1; lod < rgm.numLods; lod++) {
+			refine = refine.then(() => fetchRgm(dir, file, lod)).then((rgmLod) => {
+				// Ignore stale levels from an interrupted preprocessing run
+				if (rgmLod.hash !== rgm.hash) throw new Error("Stale preprocessed mesh: " + dir + file);
+				mesh.geometry.dispose();
+				mesh.geometry = rgmLod.geometry;
+			});
+		}
+		refine.catch((e) => console.warn(e.message));
+		return mesh;
+	});
+}
+
+// Promises of the sets of cached meshes in each directory, listed in
+// rgm_index.txt by redis_gl_mesh_preprocess.
+let rgmIndices = {};
+
+function hasRgm(dir, file) {
+	if (!(dir in rgmIndices)) {
+		rgmIndices[dir] = fetch(dir + "rgm_index.txt")
+			.then((response) => response.ok ? response.text() : "")
+			.then((text) => new Set(text.split("\n").filter((line) => line)))
+			.catch(() => new Set());
+	}
+	return rgmIndices[dir].then((index) => index.has(file));
+}
+
+/**
+ * Loads the preprocessed levels of a mesh if its directory lists them, and
+ * otherwise the original file.
+ */
+function loadPreprocessed(dir, file, loadOriginal) {
+	return hasRgm(dir, file).then((has) => {
+		if (!has) return loadOriginal(dir, file);
+		return loadRgm(dir, file).catch(() => loadOriginal(dir, file));
+	});
+}
+
 export function parse(graphicsStruct, body, promises) {
 
 	const T_to_parent = graphicsStruct["T_to_parent"];
@@ -82,13 +176,14 @@ export function parse(graphicsStruct, body, promises) {
 		const file = meshFilename.substr(meshFilename.lastIndexOf("/") + 1);
 		const ext = meshFilename.substr(meshFilename.lastIndexOf(".") + 1).toLowerCase();
 
+		// Prefer meshes preprocessed by redis_gl_mesh_preprocess
 		let promise;
 		if (ext === "obj") {
-			promise = loadObj(dir, file);
+			promise = loadPreprocessed(dir, file, loadObj);
 		} else if (ext === "dae") {
 			promise = loadDae(dir, file);
 		} else if (ext === "stl") {
-			promise = loadStl(dir, file);
+			promise = loadPreprocessed(dir, file, loadStl);
 		} else {
 			console.error("Unsupported filetype: " + meshFilename);
 			return;
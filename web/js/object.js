@@ -8,6 +8,7 @@
  */
 
 import * as Graphics from "./graphics.js"
+import * as Codec from "./codec.js"
 import * as Redis from "./redis.js"
 
 var AXIS_WIDTH = 0.005;
@@ -31,7 +32,7 @@ export function create(model, loadCallback) {
 }
 
 export function updatePosition(object, val) {
-	const pos = Redis.makeNumeric(val[0]);
+	const pos = Codec.toVector(val);
 	if (object.matrixAutoUpdate) {
 		object.position.fromArray(pos);
 	} else {
@@ -41,13 +42,13 @@ export function updatePosition(object, val) {
 }
 
 export function updateOrientation(object, val) {
-	const quat = Redis.makeNumeric(val[0]);
+	const quat = Codec.toQuaternion(val);
 	object.quaternion.set(quat[0], quat[1], quat[2], quat[3]);
 	return true;
 }
 
 export function updateScale(object, val) {
-	const scale = Redis.makeNumeric(val[0]);
+	const scale = Codec.toVector(val);
 	object.scale.fromArray(scale);
 	return true;
 }
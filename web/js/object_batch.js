@@ -0,0 +1,145 @@
+/**
+ * object_batch.js
+ *
+ * Copyright 2019. All Rights Reserved.
+ *
+ * Created: October 16, 2026
+ * Authors: Toki Migimatsu
+ */
+
+import * as Graphics from "./graphics.js"
+
+let REDISGL_OBJECT_BATCH_MAGIC = [0xff, 0x52, 0x47, 0x49];  // "\xffRGI"
+let REDISGL_OBJECT_BATCH_HEADER_SIZE = 16;
+let REDISGL_OBJECT_BATCH_SCALES = 1 << 0;
+let REDISGL_OBJECT_BATCH_COLORS = 1 << 1;
+
+export function create(model, loadCallback) {
+	let batch = new THREE.Object3D();
+	batch.redisgl = {
+		parts: null,     // Geometry and material of each graphics primitive
+		buffer: null,    // Latest instances received before the graphics loaded
+		capacity: 0,
+		colors: false
+	};
+
+	// Load the graphics into a template whose meshes are instanced
+	let template = new THREE.Object3D();
+	let promises = [];
+	Graphics.parse(model["graphics"], template, promises);
+
+	Promise.all(promises).then(() => {
+		let parts = [];
+		template.updateMatrixWorld(true);
+		template.traverse((obj) => {
+			if (!obj.isMesh) return;
+
+			// Bake the transform of the primitive into its geometry
+			const geometry = obj.geometry.clone().applyMatrix4(obj.matrixWorld);
+			parts.push({ geometry: geometry, material: obj.material });
+		});
+		batch.redisgl.parts = parts;
+
+		if (batch.redisgl.buffer !== null) {
+			updateInstances(batch, batch.redisgl.buffer);
+			batch.redisgl.buffer = null;
+		}
+		loadCallback(batch);
+	});
+	return batch;
+}
+
+function createMeshes(batch, capacity, colors) {
+	let spec = batch.redisgl;
+	batch.children.slice().forEach((mesh) => {
+		batch.remove(mesh);
+		mesh.dispatchEvent({ type: "dispose" });
+	});
+
+	spec.parts.forEach((part) => {
+		let material = part.material;
+		if (colors) {
+			// Instance colors replace the material color
+			material = new THREE.MeshLambertMaterial({
+				color: 0xffffff,
+				transparent: part.material.transparent,
+				opacity: part.material.opacity
+			});
+		}
+		let mesh = new THREE.InstancedMesh(part.geometry, material, capacity);
+		mesh.instanceMatrix.setUsage(THREE.DynamicDrawUsage);
+		if (colors) {
+			mesh.instanceColor = new THREE.InstancedBufferAttribute(new Float32Array(3 * capacity), 3);
+			mesh.instanceColor.setUsage(THREE.DynamicDrawUsage);
+		}
+
+		// Instances span more than the bounds of the template geometry
+		mesh.frustumCulled = false;
+		batch.add(mesh);
+	});
+	spec.capacity = capacity;
+	spec.colors = colors;
+}
+
+let position = new THREE.Vector3();
+let quaternion = new THREE.Quaternion();
+let scale = new THREE.Vector3();
+let matrix = new THREE.Matrix4();
+
+export function updateInstances(batch, buffer) {
+	if (buffer.constructor !== ArrayBuffer) return false;
+	if (buffer.byteLength < REDISGL_OBJECT_BATCH_HEADER_SIZE) return false;
+	const magic = new Uint8Array(buffer, 0, REDISGL_OBJECT_BATCH_MAGIC.length);
+	if (!REDISGL_OBJECT_BATCH_MAGIC.every((byte, i) => magic[i] === byte)) return false;
+
+	let spec = batch.redisgl;
+	if (spec.parts === null) {
+		// Apply once the graphics have loaded
+		spec.buffer = buffer;
+		return false;
+	}
+
+	const dv = new DataView(buffer);
+	const flags = dv.getUint8(5);
+	const numInstances = dv.getUint32(8, true);
+	const hasScales = (flags & REDISGL_OBJECT_BATCH_SCALES) !== 0;
+	const hasColors = (flags & REDISGL_OBJECT_BATCH_COLORS) !== 0;
+
+	let offset = REDISGL_OBJECT_BATCH_HEADER_SIZE;
+	const poses = new Float32Array(buffer, offset, 7 * numInstances);
+	offset += poses.byteLength;
+	const scales = hasScales ? new Float32Array(buffer, offset, 3 * numInstances) : null;
+	offset += hasScales ? scales.byteLength : 0;
+	const colors = hasColors ? new Uint8Array(buffer, offset, 3 * numInstances) : null;
+
+	// Reallocate with headroom so small changes in size reuse the buffers
+	if (numInstances > spec.capacity || hasColors !== spec.colors) {
+		createMeshes(batch, Math.max(1, Math.ceil(1.5 * numInstances)), hasColors);
+	}
+	if (batch.children.length === 0) return false;
+
+	// Compose the instance matrices once and copy them to every primitive
+	let instanceMatrix = batch.children[0].instanceMatrix.array;
+	scale.set(1, 1, 1);
+	for (let i = 0; i < numInstances; i++) {
+		position.fromArray(poses, 7 * i);
+		quaternion.fromArray(poses, 7 * i + 3);
+		if (hasScales) scale.fromArray(scales, 3 * i);
+		matrix.compose(position, quaternion, scale);
+		matrix.toArray(instanceMatrix, 16 * i);
+	}
+
+	batch.children.forEach((mesh, idx) => {
+		if (idx > 0) mesh.instanceMatrix.array.set(instanceMatrix.subarray(0, 16 * numInstances));
+		mesh.instanceMatrix.needsUpdate = true;
+		if (hasColors) {
+			let instanceColor = mesh.instanceColor.array;
+			for (let i = 0; i < 3 * numInstances; i++) {
+				instanceColor[i] = colors[i] / 255;
+			}
+			mesh.instanceColor.needsUpdate = true;
+		}
+		mesh.count = numInstances;
+	});
+	return true;
+}
@@ -279,42 +279,48 @@ function parsePayload(buffer, idx) {
 
 export function parseMessage(buffer) {
 	let idx = 0;
-
-	// Parse number of keys to update
-	const numUpdates = new DataView(buffer, idx).getUint32();
-	idx += 4;
-
 	let updateKeyVals = {};
-	for (let i = 0; i < numUpdates; i++) {
-		// Parse key
-		const idxKey = parsePayload(buffer, idx);
-		idx = idxKey[0];
-		const key = idxKey[1];
-
-		// Parse val
-		const idxVal = parsePayload(buffer, idx);
-		idx = idxVal[0];
-		const val = idxVal[1];
-
-		updateKeyVals[key] = val;
-	}
+	let deleteKeys = new Set();
+
+	// A message may hold several update messages in a row (e.g. a snapshot
+	// followed by a delta), which are applied in order
+	while (idx < buffer.byteLength) {
+		// Parse number of keys to update
+		const numUpdates = new DataView(buffer, idx).getUint32();
+		idx += 4;
+
+		for (let i = 0; i < numUpdates; i++) {
+			// Parse key
+			const idxKey = parsePayload(buffer, idx);
+			idx = idxKey[0];
+			const key = idxKey[1];
+
+			// Parse val
+			const idxVal = parsePayload(buffer, idx);
+			idx = idxVal[0];
+			const val = idxVal[1];
+
+			updateKeyVals[key] = val;
+			deleteKeys.delete(key);
+		}
 
-	// Parse number of keys to delete
-	const numDeletes = (new DataView(buffer, idx)).getUint32();
-	idx += 4;
+		// Parse number of keys to delete
+		const numDeletes = (new DataView(buffer, idx)).getUint32();
+		idx += 4;
 
-	let deleteKeys = [];
-	for (let i = 0; i < numDeletes; i++) {
-		// Parse key
-		const idxKey = parsePayload(buffer, idx);
-		idx = idxKey[0];
-		const key = idxKey[1];
+		for (let i = 0; i < numDeletes; i++) {
+			// Parse key
+			const idxKey = parsePayload(buffer, idx);
+			idx = idxKey[0];
+			const key = idxKey[1];
 
-		deleteKeys.push(key);
+			delete updateKeyVals[key];
+			deleteKeys.add(key);
+		}
 	}
 
 	return {
 		toUpdate: updateKeyVals,
-		toDelete: deleteKeys
+		toDelete: Array.from(deleteKeys)
 	};
 }
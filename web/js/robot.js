@@ -8,14 +8,22 @@
  */
 
 import * as Graphics from "./graphics.js"
+import * as Codec from "./codec.js"
 import * as Redis from "./redis.js"
 
 var AXIS_WIDTH = 0.005;
 var AXIS_SIZE = 0.1;
 
+let REDISGL_LINK_TRANSFORMS_MAGIC = [0xff, 0x52, 0x47, 0x4b];  // "\xffRGK"
+let REDISGL_LINK_TRANSFORMS_HEADER_SIZE = 16;
+
 export function create(model, loadCallback) {
 	const ab = model["articulated_body"];
 
+	// Link transforms computed by the server are relative to the base, so all
+	// bodies are attached directly to the base.
+	const hasLinkTransforms = !!model["key_link_transforms"];
+
 	// Create base
 	let base = new THREE.Object3D();
 	const T_to_world = ab["T_base_to_world"];
@@ -39,7 +47,7 @@ export function create(model, loadCallback) {
 	let bodies = [];
 	ab["rigid_bodies"].forEach((rb) => {
 		// Set parent
-		let parent = rb["id_parent"] < 0 ? base : bodies[rb["id_parent"]];
+		let parent = rb["id_parent"] < 0 || hasLinkTransforms ? base : bodies[rb["id_parent"]];
 
 		// Create body
 		let body = new THREE.Object3D();
@@ -80,6 +88,13 @@ export function create(model, loadCallback) {
 		axes.visible = false;//rb.id_parent < 0 || ee_ids.has(rb.id);
 		body.add(axes);
 
+		// Start in the zero configuration until the first transforms arrive
+		if (hasLinkTransforms) {
+			body.updateMatrix();
+			if (rb["id_parent"] >= 0) body.matrix.premultiply(bodies[rb["id_parent"]].matrix);
+			body.matrixAutoUpdate = false;
+		}
+
 		// Add body to parent
 		bodies.push(body);
 		parent.add(body);
@@ -96,7 +111,7 @@ export function create(model, loadCallback) {
 }
 
 export function updateQ(robot, val) {
-	const q = Redis.makeNumeric(val[0]);
+	const q = Codec.toVector(val);
 	const spec = robot.redisgl;
 	let bodies = spec.bodies;
 	spec.q = q;
@@ -127,14 +142,31 @@ export function updateQ(robot, val) {
 	return true;
 }
 
+export function updateLinkTransforms(robot, buffer) {
+	if (buffer.constructor !== ArrayBuffer) return false;
+	if (buffer.byteLength < REDISGL_LINK_TRANSFORMS_HEADER_SIZE) return false;
+	const magic = new Uint8Array(buffer, 0, REDISGL_LINK_TRANSFORMS_MAGIC.length);
+	if (!REDISGL_LINK_TRANSFORMS_MAGIC.every((byte, i) => magic[i] === byte)) return false;
+
+	const numLinks = new DataView(buffer).getUint32(8, true);
+	const transforms = new Float32Array(buffer, REDISGL_LINK_TRANSFORMS_HEADER_SIZE, 16 * numLinks);
+	let bodies = robot.redisgl.bodies;
+	const n = Math.min(numLinks, bodies.length);
+	for (let i = 0; i < n; i++) {
+		bodies[i].matrix.fromArray(transforms, 16 * i);
+		bodies[i].matrixWorldNeedsUpdate = true;
+	}
+	return true;
+}
+
 export function updatePosition(robot, val) {
-	const pos = Redis.makeNumeric(val[0]);
+	const pos = Codec.toVector(val);
 	robot.position.fromArray(pos);
 	return true;
 }
 
 export function updateOrientation(robot, val) {
-	const quat = Redis.makeNumeric(val[0]);
+	const quat = Codec.toQuaternion(val);
 	robot.quaternion.set(quat[0], quat[1], quat[2], quat[3]);
 	return true;
 }
@@ -8,6 +8,7 @@
 import * as Camera from "./camera.js"
 import * as Graphics from "./graphics.js"
 import * as GraphicsObject from "./object.js"
+import * as ObjectBatch from "./object_batch.js"
 import * as Redis from "./redis.js"
 import * as Robot from "./robot.js"
 import * as Trajectory from "./trajectory.js"
@@ -21,20 +22,45 @@ var KEY_CAMERA_POS = "webapp::simulator::camera::pos";
 var KEY_CAMERA_TARGET = "webapp::simulator::camera::target";
 var KEY_TRAJ_RESET = "webapp::simulator::trajectory::reset";
 var KEY_AXES_VISIBLE = "webapp::simulator::axes::visible";
+var REGEX_LATENCY_STAMP = /::latency::stamp::/;
+var LATENCY_REPORT_PERIOD = 1000;
+var LATENCY_REPORT_MAX_SAMPLES = 64;
+var FRAME_TIMEOUT = 1000;  // ms without frames before direct updates resume
+var DESCRIPTION_TIMEOUT = 5000;  // ms before reporting a missing description
 
 $(document).ready(function() {
 
 	let handlingMessage = false;
-
-	// Set up web socket
-	$.get("/get_websocket_port", function(ws_port) {
-		let ws = new WebSocket("ws://" + window.location.hostname + ":" + ws_port);
+	let ws = null;
+
+	// Latency samples of stamp keys to report to the server
+	let latencies = {};
+
+	// Set up web socket. The ws_port url parameter connects to another
+	// server, such as a StreamServer embedded in the controller, and the
+	// namespace url parameter subscribes to the keys of the given namespaces.
+	function connectWebSocket(ws_port) {
+		let url = "ws://" + window.location.hostname + ":" + ws_port;
+		if (urlParams.has("namespace")) {
+			url += "/?namespace=" + encodeURIComponent(urlParams.get("namespace"));
+		}
+		ws = new WebSocket(url);
 		ws.onmessage = (e) => {
 			if (handlingMessage) return;
 			handlingMessage = true;
-			new Response(e.data).arrayBuffer().then(handleMessage);
+			const tReceive = performance.now();
+			new Response(e.data).arrayBuffer().then((buffer) => {
+				handleMessage(buffer, tReceive);
+			});
 		}
-	});
+		setInterval(sendLatencyReport, LATENCY_REPORT_PERIOD);
+	}
+	const urlParams = new URLSearchParams(window.location.search);
+	if (urlParams.has("ws_port")) {
+		connectWebSocket(urlParams.get("ws_port"));
+	} else {
+		$.get("/get_websocket_port", connectWebSocket);
+	}
 
 	let camera, scene, renderer, raycaster, controls;
 
@@ -52,17 +78,25 @@ $(document).ready(function() {
 	let args = {};
 	let robots = {};
 	let objects = {};
+	let objectBatches = {};
 	let trajectories = {};
 	let cameras = {};
+	let frames = {};
+	let descriptions = {};
+	let pendingModels = {};
+	let modelVals = {};
 
 	initGraphics();
 
-	function handleMessage(buffer) {
+	function handleMessage(buffer, tReceive) {
 		const keys = Redis.parseMessage(buffer);
 
 		// Initialize webapp args
 		parseArgs(keys.toUpdate);
 
+		// Apply complete frames
+		parseFrames(keys.toUpdate);
+
 		// Parse models
 		parseModels(keys.toUpdate);
 
@@ -76,9 +110,51 @@ $(document).ready(function() {
 		if (renderFrame) {
 			renderer.render(scene, camera);
 		}
+		recordLatencies(keys.toUpdate, performance.now() - tReceive);
 		handlingMessage = false;
 	};
 
+	function recordLatencies(keyVals, latency) {
+		for (const key in keyVals) {
+			if (!REGEX_LATENCY_STAMP.test(key)) continue;
+			const seq = parseInt(keyVals[key]);
+			if (isNaN(seq)) continue;
+
+			if (!(key in latencies)) {
+				latencies[key] = { samples: [], dropped: 0, seq: seq - 1 };
+			}
+			const stats = latencies[key];
+			if (seq === stats.seq) continue;
+
+			// Stamps skipped while busy or dropped upstream leave a gap. A
+			// smaller sequence number means the controller restarted.
+			if (seq > stats.seq) stats.dropped += seq - stats.seq - 1;
+			stats.seq = seq;
+			stats.samples.push(latency);
+		}
+	}
+
+	function sendLatencyReport() {
+		if (ws === null || ws.readyState !== WebSocket.OPEN) return;
+
+		let report = {};
+		let empty = true;
+		for (const key in latencies) {
+			const stats = latencies[key];
+			if (stats.samples.length === 0 && stats.dropped === 0) continue;
+			report[key] = {
+				samples: stats.samples.slice(-LATENCY_REPORT_MAX_SAMPLES)
+					.map((x) => Math.round(1000 * x) / 1000),
+				dropped: stats.dropped
+			};
+			stats.samples = [];
+			stats.dropped = 0;
+			empty = false;
+		}
+		if (empty) return;
+		ws.send(JSON.stringify({ latency: report }));
+	}
+
 	function registerRedisUpdateCallback(key, keyComponent, component, updateCallback) {
 		if (key === "") return;
 		if (!(key in redisUpdateCallbacks)) {
@@ -124,10 +200,16 @@ $(document).ready(function() {
 			// Load already existing models
 			Redis.getKeys().forEach((key) => {
 				let parseModelFunction;
-				if (key.startsWith(args[namespace]["key_cameras_prefix"])) {
+				if (args[namespace]["key_descriptions_prefix"] &&
+					key.startsWith(args[namespace]["key_descriptions_prefix"])) {
+					parseModelFunction = parseDescription;
+				} else if (key.startsWith(args[namespace]["key_cameras_prefix"])) {
 					parseModelFunction = parseCameraModel;
 				} else if (key.startsWith(args[namespace]["key_objects_prefix"])) {
 					parseModelFunction = parseObjectModel;
+				} else if (args[namespace]["key_object_batches_prefix"] &&
+					key.startsWith(args[namespace]["key_object_batches_prefix"])) {
+					parseModelFunction = parseObjectBatchModel;
 				} else if (key.startsWith(args[namespace]["key_robots_prefix"])) {
 					parseModelFunction = parseRobotModel;
 				} else if (key.startsWith(args[namespace]["key_trajectories_prefix"])) {
@@ -141,6 +223,58 @@ $(document).ready(function() {
 		}
 	}
 
+	function isFrameKey(key) {
+		for (const namespace in args) {
+			if (args[namespace]["key_frame"] === key) return true;
+		}
+		return false;
+	}
+
+	function parseFrames(keyVals) {
+		let frameVals = {};
+		for (const key in keyVals) {
+			if (!isFrameKey(key)) continue;
+			const val = keyVals[key];
+			delete keyVals[key];
+
+			let frame;
+			try {
+				frame = JSON.parse(val);
+			} catch (error) {
+				console.error(error);
+				console.error("Failed to parse frame " + key + ":\n" + val);
+				continue;
+			}
+
+			// Skip stale frames from the same publisher
+			const frameLast = frames[key];
+			if (frameLast && frameLast.epoch === frame.epoch && frame.id <= frameLast.id) continue;
+			frames[key] = {
+				epoch: frame.epoch,
+				id: frame.id,
+				keys: new Set(Object.keys(frame.values)),
+				tReceive: performance.now(),
+			};
+
+			for (const keyVal in frame.values) {
+				frameVals[keyVal] = frame.values[keyVal];
+			}
+		}
+
+		// Keys in the latest frames are only updated through complete frames,
+		// since individually polled values may belong to different ticks.
+		// Once a publisher stops sending frames, direct updates apply again.
+		const tNow = performance.now();
+		for (const key in frames) {
+			const frame = frames[key];
+			if (tNow - frame.tReceive > FRAME_TIMEOUT) continue;
+			frame.keys.forEach((keyVal) => {
+				delete keyVals[keyVal];
+			});
+		}
+		Object.assign(keyVals, frameVals);
+	}
+
 	function parseModels(keyVals) {
 		for (const key in keyVals) {
 			let val = keyVals[key];
@@ -148,10 +282,15 @@ $(document).ready(function() {
 			// Skip binary objects
 			if (typeof (val) === "object") continue;
 
+			// Skip models that haven't changed
+			if (modelVals[key] === val) continue;
+
 			// Try parsing all model types
 			try {
-				if (!parseCameraModel(key, val) &&
+				if (!parseDescription(key, val) &&
+					!parseCameraModel(key, val) &&
 					!parseObjectModel(key, val) &&
+					!parseObjectBatchModel(key, val) &&
 					!parseRobotModel(key, val) &&
 					!parseTrajectoryModel(key, val)) continue;
 			} catch (error) {
@@ -161,29 +300,95 @@ $(document).ready(function() {
 			}
 
 			// Update html
+			modelVals[key] = val;
 			Redis.updateForm(key, val, true, true, true);
 		}
 	}
 
 	function isModelKey(key, keyPrefix) {
+		return findArgs(key, keyPrefix) !== null;
+	}
+
+	function findArgs(key, keyPrefix) {
 		for (const modelKeys in args) {
-			if (args[modelKeys][keyPrefix] !== "" &&
-				key.startsWith(args[modelKeys][keyPrefix])) return true;
+			if (args[modelKeys][keyPrefix] &&
+				key.startsWith(args[modelKeys][keyPrefix])) return args[modelKeys];
 		}
-		return false;
+		return null;
+	}
+
+	function parseDescription(key, val) {
+		if (!isModelKey(key, "key_descriptions_prefix")) return false;
+
+		descriptions[key] = JSON.parse(val);
+
+		// Parse models that were waiting for this description
+		if (key in pendingModels) {
+			const pending = pendingModels[key];
+			delete pendingModels[key];
+			for (const keyModel in pending) {
+				pending[keyModel]();
+			}
+		}
+		return true;
+	}
+
+	function getDescription(key, val, keyPrefix, hash, parseModelFunction) {
+		// Models registered through the model cache reference a shared
+		// description stored under its content hash.
+		const keyDescription = findArgs(key, keyPrefix)["key_descriptions_prefix"] + hash;
+		if (!(keyDescription in descriptions) && Redis.formExists(keyDescription)) {
+			descriptions[keyDescription] = JSON.parse(Redis.getValue(keyDescription));
+		}
+		if (keyDescription in descriptions) return descriptions[keyDescription];
+
+		// Parse the model once the description arrives
+		if (!(keyDescription in pendingModels)) {
+			pendingModels[keyDescription] = {};
+
+			// Report descriptions that never arrive, e.g. after Redis lost
+			// them. Models keep waiting until the publisher resends them.
+			setTimeout(() => {
+				if (!(keyDescription in pendingModels)) return;
+				const keysModels = Object.keys(pendingModels[keyDescription]);
+				if (keysModels.length === 0) return;
+				console.error("Missing description " + keyDescription +
+					" for models: " + keysModels.join(", "));
+			}, DESCRIPTION_TIMEOUT);
+		}
+		pendingModels[keyDescription][key] = () => parseModelFunction(key, val);
+		return null;
 	}
 
 	function parseRobotModel(key, val) {
 		if (!isModelKey(key, "key_robots_prefix")) return false;
 
 		// Parse robot model
-		const model = JSON.parse(val);
+		let model = JSON.parse(val);
+		if ("articulated_body_hash" in model) {
+			const description = getDescription(key, val, "key_robots_prefix",
+				model["articulated_body_hash"], parseRobotModel);
+			if (description === null) return true;
+			model["articulated_body"] = Object.assign({
+				name: model["name"],
+				T_base_to_world: model["T_base_to_world"]
+			}, description);
+		}
 		addComponentToScene(Robot, robots, key, model);
-		registerRedisUpdateCallback(model["key_q"], key, robots[key], (robot, val) => {
-			const renderFrame = Robot.updateQ(robot, val);
-			updateInteraction(key, robot.redisgl.bodies);
-			return renderFrame;
-		});
+		if (model["key_link_transforms"]) {
+			// Forward kinematics are computed by the publisher
+			registerRedisUpdateCallback(model["key_link_transforms"], key, robots[key], (robot, val) => {
+				const renderFrame = Robot.updateLinkTransforms(robot, val);
+				updateInteraction(key, robot.redisgl.bodies);
+				return renderFrame;
+			});
+		} else {
+			registerRedisUpdateCallback(model["key_q"], key, robots[key], (robot, val) => {
+				const renderFrame = Robot.updateQ(robot, val);
+				updateInteraction(key, robot.redisgl.bodies);
+				return renderFrame;
+			});
+		}
 		registerRedisUpdateCallback(model["key_pos"], key, robots[key], Robot.updatePosition);
 		registerRedisUpdateCallback(model["key_ori"], key, robots[key], Robot.updateOrientation);
 		console.log("New robot: " + key);
@@ -193,7 +398,13 @@ $(document).ready(function() {
 	function parseObjectModel(key, val) {
 		if (!isModelKey(key, "key_objects_prefix")) return false;
 
-		const model = JSON.parse(val);
+		let model = JSON.parse(val);
+		if ("graphics_hash" in model) {
+			const description = getDescription(key, val, "key_objects_prefix",
+				model["graphics_hash"], parseObjectModel);
+			if (description === null) return true;
+			model["graphics"] = description;
+		}
 		addComponentToScene(GraphicsObject, objects, key, model);
 		registerRedisUpdateCallback(model["key_pos"], key, objects[key], (object, val) => {
 			const renderFrame = GraphicsObject.updatePosition(object, val);
@@ -225,13 +436,27 @@ $(document).ready(function() {
 		return true;
 	}
 
+	function parseObjectBatchModel(key, val) {
+		if (!isModelKey(key, "key_object_batches_prefix")) return false;
+
+		const model = JSON.parse(val);
+		addComponentToScene(ObjectBatch, objectBatches, key, model);
+		registerRedisUpdateCallback(model["key_instances"], key, objectBatches[key], ObjectBatch.updateInstances);
+		console.log("New object batch: " + key);
+		return true;
+	}
+
 	function parseTrajectoryModel(key, val) {
 		if (!isModelKey(key, "key_trajectories_prefix")) return false;
 
 		// Parse object model
 		const model = JSON.parse(val);
 		addComponentToScene(Trajectory, trajectories, key, model);
-		registerRedisUpdateCallback(model["key_pos"], key, trajectories[key], Trajectory.appendPosition);
+		if (model["key_samples"]) {
+			registerRedisUpdateCallback(model["key_samples"], key, trajectories[key], Trajectory.updateSamples);
+		} else {
+			registerRedisUpdateCallback(model["key_pos"], key, trajectories[key], Trajectory.appendPosition);
+		}
 		console.log("New trajectory: " + key);
 		return true;
 	}
@@ -245,8 +470,23 @@ $(document).ready(function() {
 		registerRedisUpdateCallback(model["key_pos"], key, cameras[key], Camera.updatePosition);
 		registerRedisUpdateCallback(model["key_ori"], key, cameras[key], Camera.updateOrientation);
 		registerRedisUpdateCallback(model["key_intrinsic"], key, cameras[key], Camera.updateIntrinsic);
-		registerRedisUpdateCallback(model["key_depth_image"], key, cameras[key], Camera.updateDepthImage);
-		registerRedisUpdateCallback(model["key_color_image"], key, cameras[key], Camera.updateColorImage);
+
+		// Register every pyramid level. The camera only renders its current level.
+		const numLevels = model["num_levels"] || 1;
+		for (let level = 0; level < numLevels; level++) {
+			const suffix = level === 0 ? "" : "::level::" + level;
+			if (model["key_depth_image"]) {
+				registerRedisUpdateCallback(model["key_depth_image"] + suffix, key, cameras[key],
+					(camera, val, renderCallback) => Camera.updateDepthImage(camera, val, renderCallback, level));
+			}
+			if (model["key_color_image"]) {
+				registerRedisUpdateCallback(model["key_color_image"] + suffix, key, cameras[key],
+					(camera, val, renderCallback) => Camera.updateColorImage(camera, val, renderCallback, level));
+			}
+		}
+		if (model["key_point_cloud"]) {
+			registerRedisUpdateCallback(model["key_point_cloud"], key, cameras[key], Camera.updatePointCloud);
+		}
 		console.log("New camera: " + key);
 		return true;
 	}
@@ -301,6 +541,12 @@ $(document).ready(function() {
 		let renderFrame = false;
 
 		keys.forEach((key) => {
+			delete modelVals[key];
+			delete descriptions[key];
+			delete frames[key];
+			for (const keyDescription in pendingModels) {
+				delete pendingModels[keyDescription][key];
+			}
 			if (key in robots) {
 				scene.remove(robots[key]);
 				delete robots[key];
@@ -311,6 +557,11 @@ $(document).ready(function() {
 				delete objects[key];
 				unregisterRedisUpdateCallback(key);
 				renderFrame = true;
+			} else if (key in objectBatches) {
+				scene.remove(objectBatches[key]);
+				delete objectBatches[key];
+				unregisterRedisUpdateCallback(key);
+				renderFrame = true;
 			}
 			Redis.deleteForm(key);
 		});
@@ -7,7 +7,7 @@
  * Authors: Toki Migimatsu
  */
 
-import * as Redis from "./redis.js"
+import * as Codec from "./codec.js"
 
 var LEN_TRAJECTORY_TRAIL = 500;
 
@@ -16,6 +16,7 @@ export function create(model, loadCallback) {
 	traj.redisgl = {
 		idx: 0,
 		len: 0,
+		sequence: -1,
 	};
 
 	let material = new THREE.LineBasicMaterial({ color: 0xffffff });
@@ -29,12 +30,21 @@ export function create(model, loadCallback) {
 		traj.add(new THREE.Line(geometry, material));
 	}
 
+	// Segment from the last vertex to the provisional head
+	let geometryHead = new THREE.BufferGeometry();
+	geometryHead.setDrawRange(0, 0);
+	geometryHead.setAttribute("position", new THREE.BufferAttribute(new Float32Array(6), 3));
+	traj.add(new THREE.Line(geometryHead, material));
+
 	loadCallback(traj);
 	return traj;
 }
 
 export function appendPosition(traj, val) {
-	const pos = Redis.makeNumeric(val[0]);
+	appendVertex(traj, Codec.toVector(val));
+}
+
+function appendVertex(traj, pos) {
 	let geometry1 = traj.children[0].geometry;
 	let geometry2 = traj.children[1].geometry;
 	let spec = traj.redisgl;
@@ -58,6 +68,57 @@ export function appendPosition(traj, val) {
 	}
 }
 
+let REDISGL_TRAJECTORY_MAGIC = [0xff, 0x52, 0x47, 0x54];  // "\xffRGT"
+let REDISGL_TRAJECTORY_HEADER_SIZE = 24;
+
+/**
+ * Appends the simplified samples published by
+ * redis_gl::simulator::TrajectoryPublisher. Only vertices newer than the last
+ * one seen are appended, so the trail uses constant memory.
+ */
+export function updateSamples(traj, buffer) {
+	if (buffer.constructor !== ArrayBuffer) return false;
+	if (buffer.byteLength < REDISGL_TRAJECTORY_HEADER_SIZE) return false;
+	const magic = new Uint8Array(buffer, 0, REDISGL_TRAJECTORY_MAGIC.length);
+	if (!REDISGL_TRAJECTORY_MAGIC.every((byte, i) => magic[i] === byte)) return false;
+
+	const dv = new DataView(buffer);
+	const hasHead = (dv.getUint8(5) & 1) !== 0;
+	const numVertices = dv.getUint32(8, true);
+	const baseSeq = dv.getUint32(16, true) + dv.getUint32(20, true) * 4294967296;
+	const positions = new Float32Array(buffer, REDISGL_TRAJECTORY_HEADER_SIZE, 3 * numVertices);
+	const offsets = new Uint32Array(buffer, REDISGL_TRAJECTORY_HEADER_SIZE + positions.byteLength, numVertices);
+	const numFinal = hasHead ? numVertices - 1 : numVertices;
+
+	// Reset if the publisher restarted
+	let spec = traj.redisgl;
+	if (numFinal > 0 && baseSeq + offsets[numFinal - 1] < spec.sequence) {
+		reset(traj);
+		spec.sequence = -1;
+	}
+
+	for (let i = 0; i < numFinal; i++) {
+		const seq = baseSeq + offsets[i];
+		if (seq <= spec.sequence) continue;
+		appendVertex(traj, positions.subarray(3 * i, 3 * i + 3));
+		spec.sequence = seq;
+	}
+
+	// Draw the provisional head from the last vertex
+	let geometryHead = traj.children[2].geometry;
+	if (hasHead && spec.len > 0) {
+		const idxLast = spec.idx > 0 ? spec.idx - 1 : 0;
+		const last = traj.children[0].geometry.attributes.position.array.subarray(3 * idxLast, 3 * idxLast + 3);
+		geometryHead.attributes.position.set(last, 0);
+		geometryHead.attributes.position.set(positions.subarray(3 * numFinal, 3 * numFinal + 3), 3);
+		geometryHead.attributes.position.needsUpdate = true;
+		geometryHead.setDrawRange(0, 2);
+	} else {
+		geometryHead.setDrawRange(0, 0);
+	}
+	return true;
+}
+
 export function reset(traj) {
 	let spec = traj.redisgl;
 	spec.idx = 0;
@@ -69,5 +130,6 @@ export function reset(traj) {
 	geometry1.attributes.position.needsUpdate = true;
 	geometry2.setDrawRange(0, 0);
 	geometry2.attributes.position.needsUpdate = true;
+	traj.children[2].geometry.setDrawRange(0, 0);
 }
 